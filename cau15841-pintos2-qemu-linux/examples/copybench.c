@@ -0,0 +1,132 @@
+/* copybench.c
+
+   Compares copying a large file by reading it into a buffer and
+   writing the buffer back out, the way cp used to, with copying
+   it inside the kernel with copy_file_range().
+
+   The in-kernel copy moves each sector from one file to the
+   other without the data crossing into user memory and back, so
+   it should save the cost of checking and copying the user
+   buffer twice per chunk.
+
+   Usage: copybench */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <syscall.h>
+
+/* Size of the file copied. */
+#define FILE_SIZE (256 * 1024)
+
+/* Copies to time for each method. */
+#define ITERATIONS 4
+
+/* User buffer sizes to try, then 0 for copy_file_range(). */
+static const int chunks[] = {512, 1024, 2048, 4096, 0};
+
+static char buf[4096];
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Opens FILE_NAME, creating it FILE_SIZE bytes long first.
+   Returns the file descriptor, or -1 on failure. */
+static int
+create_file (const char *file_name)
+{
+  int fd;
+
+  remove (file_name);
+  if (!create (file_name, FILE_SIZE))
+    {
+      printf ("%s: create failed\n", file_name);
+      return -1;
+    }
+  fd = open (file_name);
+  if (fd < 0)
+    printf ("%s: open failed\n", file_name);
+  return fd;
+}
+
+/* Copies IN_FD to OUT_FD from the start of each, through a user
+   buffer of CHUNK bytes, or with copy_file_range() if CHUNK is
+   0.  Returns the cycles taken, or 0 if the copy falls short. */
+static uint64_t
+copy_file (int in_fd, int out_fd, int chunk)
+{
+  uint64_t start;
+  int copied = 0;
+
+  seek (in_fd, 0);
+  seek (out_fd, 0);
+  start = rdtsc ();
+  if (chunk == 0)
+    copied = copy_file_range (in_fd, out_fd, FILE_SIZE);
+  else
+    while (copied < FILE_SIZE)
+      {
+        int bytes_read = read (in_fd, buf, chunk);
+        if (bytes_read <= 0
+            || write (out_fd, buf, bytes_read) != bytes_read)
+          break;
+        copied += bytes_read;
+      }
+  return copied == FILE_SIZE ? rdtsc () - start : 0;
+}
+
+int
+main (void)
+{
+  int in_fd, out_fd, i;
+
+  in_fd = create_file ("copybench.in");
+  out_fd = create_file ("copybench.out");
+  if (in_fd < 0 || out_fd < 0)
+    return EXIT_FAILURE;
+
+  for (i = 0; i < (int) sizeof buf; i++)
+    buf[i] = i % 64 == 63 ? '\n' : 'a' + i % 26;
+  for (i = 0; i < FILE_SIZE; i += sizeof buf)
+    if (write (in_fd, buf, sizeof buf) != sizeof buf)
+      {
+        printf ("copybench.in: write failed\n");
+        return EXIT_FAILURE;
+      }
+
+  printf ("%16s %16s\n", "method", "cycles/KB");
+  for (i = 0; i < (int) (sizeof chunks / sizeof *chunks); i++)
+    {
+      int chunk = chunks[i];
+      uint64_t cycles = 0;
+      int pass;
+
+      for (pass = 0; pass < ITERATIONS; pass++)
+        {
+          uint64_t c = copy_file (in_fd, out_fd, chunk);
+          if (c == 0)
+            {
+              printf ("copy failed\n");
+              return EXIT_FAILURE;
+            }
+          cycles += c;
+        }
+
+      if (chunk == 0)
+        printf ("%16s", "copy_file_range");
+      else
+        printf ("%10d bytes", chunk);
+      printf (" %16llu\n", cycles / ITERATIONS / (FILE_SIZE / 1024));
+    }
+
+  close (in_fd);
+  close (out_fd);
+  remove ("copybench.in");
+  remove ("copybench.out");
+  return EXIT_SUCCESS;
+}
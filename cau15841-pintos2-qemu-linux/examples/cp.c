@@ -8,7 +8,7 @@ Copies one file to another. */
 int
 main (int argc, char *argv[]) 
 {
-  int in_fd, out_fd;
+  int in_fd, out_fd, size;
 
   if (argc != 3) 
     {
@@ -25,7 +25,8 @@ main (int argc, char *argv[])
     }
 
   /* Create and open output file. */
-  if (!create (argv[2], filesize (in_fd))) 
+  size = filesize (in_fd);
+  if (!create (argv[2], size)) 
     {
       printf ("%s: create failed\n", argv[2]);
       return EXIT_FAILURE;
@@ -37,18 +38,11 @@ main (int argc, char *argv[])
       return EXIT_FAILURE;
     }
 
-  /* Copy data. */
-  for (;;) 
+  /* Copy data, within the kernel. */
+  if (copy_file_range (in_fd, out_fd, size) != size)
     {
-      char buffer[1024];
-      int bytes_read = read (in_fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
-        break;
-      if (write (out_fd, buffer, bytes_read) != bytes_read) 
-        {
-          printf ("%s: write failed\n", argv[2]);
-          return EXIT_FAILURE;
-        }
+      printf ("%s: write failed\n", argv[2]);
+      return EXIT_FAILURE;
     }
 
   return EXIT_SUCCESS;
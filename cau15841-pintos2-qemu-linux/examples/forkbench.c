@@ -0,0 +1,68 @@
+/* forkbench.c
+
+   Measures how the cost of fork() grows with the number of
+   resident pages in the forking process.
+
+   For each working-set size we touch that many pages, so that
+   they are resident and dirty, then fork repeatedly.  Each child
+   exits at once without touching anything, so the time until
+   fork() returns in the parent is the cost of duplicating the
+   address space.  With copy-on-write it should grow only by the
+   cost of sharing each page table entry, not of copying pages.
+
+   Usage: forkbench */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <syscall.h>
+
+/* Largest working set, in pages. */
+#define MAX_PAGES 512
+#define PAGE_SIZE 4096
+
+/* Forks to time at each size. */
+#define ITERATIONS 20
+
+static char working_set[MAX_PAGES][PAGE_SIZE];
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+int
+main (void)
+{
+  int page_cnt;
+
+  printf ("%8s %16s\n", "pages", "cycles/fork");
+  for (page_cnt = 0; page_cnt <= MAX_PAGES;
+       page_cnt = page_cnt == 0 ? 8 : page_cnt * 4)
+    {
+      uint64_t cycles = 0;
+      int i;
+
+      for (i = 0; i < page_cnt; i++)
+        working_set[i][0]++;
+
+      for (i = 0; i < ITERATIONS; i++)
+        {
+          uint64_t start = rdtsc ();
+          pid_t pid = fork ();
+          if (pid == 0)
+            exit (EXIT_SUCCESS);
+          cycles += rdtsc () - start;
+          if (pid < 0)
+            {
+              printf ("fork failed\n");
+              return EXIT_FAILURE;
+            }
+        }
+      printf ("%8d %16llu\n", page_cnt, cycles / ITERATIONS);
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+/* memstat.c
+
+   Prints page allocator statistics for the kernel and user
+   pools, the memory charged to this process and its working
+   set.  The user pool's peak usage is a good guide for choosing
+   the kernel's -ul option. */
+
+#include <stdio.h>
+#include <syscall.h>
+
+static void
+print_pool (const char *name, enum memstat_pool pool)
+{
+  struct palloc_stats s;
+  int i;
+
+  if (!memstat (pool, &s))
+    {
+      printf ("%s pool: memstat failed\n", name);
+      return;
+    }
+
+  printf ("%s pool: %u/%u pages used (peak %u), %u pre-zeroed, "
+          "largest free run %u\n",
+          name, s.used_cnt, s.page_cnt, s.peak_used_cnt, s.zeroed_cnt,
+          s.largest_free_run);
+  printf ("  %llu allocs (%llu pages), %llu frees (%llu pages), "
+          "%llu failures\n",
+          s.alloc_cnt, s.alloc_pages, s.free_cnt, s.free_pages, s.fail_cnt);
+  printf ("  %llu zeroed hits, %llu lock cycles in %llu acquisitions\n",
+          s.zero_hit_cnt, s.lock_cycles, s.lock_cnt);
+  for (i = 0; i < MEMSTAT_POLICY_CNT; i++)
+    printf ("  policy %d%s: %llu scans, %llu wraps, %llu failed\n",
+            i, (unsigned) i == s.policy ? " (active)" : "",
+            s.policies[i].scan_cnt, s.policies[i].wrap_cnt,
+            s.policies[i].fail_cnt);
+}
+
+static void
+print_process (void)
+{
+  struct proc_memstat s;
+
+  if (!memusage (&s))
+    {
+      printf ("process: memusage failed\n");
+      return;
+    }
+
+  printf ("process: %u resident pages (peak %u), ", s.user_pages,
+          s.peak_user_pages);
+  if (s.user_page_limit == MEMSTAT_NO_LIMIT)
+    printf ("no limit\n");
+  else
+    printf ("limit %u, %u reclaimed\n", s.user_page_limit, s.reclaim_cnt);
+  printf ("  %u page table pages, %u kernel pages, %u heap bytes\n",
+          s.pt_pages, s.kernel_pages, s.heap_bytes);
+}
+
+static void
+print_working_set (void)
+{
+  static const char *ages[WSSTAT_AGE_CNT] =
+    {"0", "1", "2-3", "4-7", "8-15", "16-31", "32+"};
+  struct proc_wsstat s;
+  int i;
+
+  if (!wsstat (&s))
+    {
+      printf ("working set: wsstat failed\n");
+      return;
+    }
+
+  printf ("working set: %u of %u resident pages used in the last "
+          "%u ms (%u samples)\n", s.ws_pages, s.resident_pages,
+          s.sample_ms * WSSTAT_WINDOW, s.sample_cnt);
+  printf ("  idle samples:");
+  for (i = 0; i < WSSTAT_AGE_CNT; i++)
+    printf (" %s=%u", ages[i], s.age_hist[i]);
+  printf ("\n");
+}
+
+int
+main (void) 
+{
+  print_pool ("kernel", MEMSTAT_KERNEL);
+  print_pool ("user", MEMSTAT_USER);
+  print_process ();
+  print_working_set ();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+/* ringbench.c
+
+   Compares the cost of small file writes made one system call at
+   a time with the same writes submitted through a ring, a batch
+   per ring_enter().
+
+   With small writes the cost of entering and leaving the kernel
+   is a large share of each call, so batching should help most
+   when the batch is large and the writes are short.
+
+   Usage: ringbench */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <syscall.h>
+#include <syscall-nr.h>
+
+/* Size of the file written. */
+#define FILE_SIZE (32 * 1024)
+
+/* Bytes per write. */
+#define WRITE_SIZE 64
+
+/* Passes over the file for each method. */
+#define ITERATIONS 4
+
+static char buf[WRITE_SIZE];
+static struct ring ring;
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Fills FD with writes of WRITE_SIZE bytes, submitting them to
+   the ring BATCH at a time, or with one write() each if BATCH is
+   0.  Returns the cycles taken, or 0 if a write fails. */
+static uint64_t
+fill_file (int fd, int batch)
+{
+  uint64_t start;
+  int ofs = 0;
+
+  seek (fd, 0);
+  start = rdtsc ();
+  while (ofs < FILE_SIZE)
+    if (batch == 0)
+      {
+        if (write (fd, buf, WRITE_SIZE) != WRITE_SIZE)
+          return 0;
+        ofs += WRITE_SIZE;
+      }
+    else
+      {
+        int i;
+
+        for (i = 0; i < batch && ofs + i * WRITE_SIZE < FILE_SIZE; i++)
+          {
+            struct ring_sqe *sqe = &ring.sq[ring.sq_tail++ % RING_ENTRIES];
+            sqe->number = SYS_WRITE;
+            sqe->args[0] = fd;
+            sqe->args[1] = (int32_t) buf;
+            sqe->args[2] = WRITE_SIZE;
+            sqe->user_data = ofs + i * WRITE_SIZE;
+          }
+        if (ring_enter (&ring) != i)
+          return 0;
+        while (ring.cq_head != ring.cq_tail)
+          if (ring.cq[ring.cq_head++ % RING_ENTRIES].result != WRITE_SIZE)
+            return 0;
+        ofs += i * WRITE_SIZE;
+      }
+  return rdtsc () - start;
+}
+
+int
+main (void)
+{
+  const char *file_name = "ringbench.tmp";
+  int batch, fd, i;
+
+  for (i = 0; i < WRITE_SIZE; i++)
+    buf[i] = 'a' + i % 26;
+
+  remove (file_name);
+  if (!create (file_name, FILE_SIZE))
+    {
+      printf ("%s: create failed\n", file_name);
+      return EXIT_FAILURE;
+    }
+  fd = open (file_name);
+  if (fd < 0)
+    {
+      printf ("%s: open failed\n", file_name);
+      return EXIT_FAILURE;
+    }
+
+  printf ("%10s %16s\n", "batch", "cycles/write");
+  for (batch = 0; batch <= RING_ENTRIES; batch = batch == 0 ? 1 : batch * 4)
+    {
+      uint64_t cycles = 0;
+      int pass;
+
+      for (pass = 0; pass < ITERATIONS; pass++)
+        {
+          uint64_t c = fill_file (fd, batch);
+          if (c == 0)
+            {
+              printf ("writes in batches of %d failed\n", batch);
+              return EXIT_FAILURE;
+            }
+          cycles += c;
+        }
+
+      if (batch == 0)
+        printf ("%10s", "none");
+      else
+        printf ("%10d", batch);
+      printf (" %16llu\n",
+              cycles / ITERATIONS / (FILE_SIZE / WRITE_SIZE));
+    }
+
+  close (fd);
+  remove (file_name);
+  return EXIT_SUCCESS;
+}
@@ -1,5 +1,6 @@
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <syscall.h>
 
@@ -26,6 +27,11 @@ main (void)
           if (!chdir (command + 3))
             printf ("\"%s\": chdir failed\n", command + 3);
         }
+      else if (!memcmp (command, "limit ", 6))
+        {
+          /* Resident page limit for commands run from now on. */
+          memlimit (atoi (command + 6));
+        }
       else if (command[0] == '\0') 
         {
           /* Empty command. */
@@ -0,0 +1,103 @@
+/* writebench.c
+
+   Measures write() throughput to a file and to the console for
+   a range of write sizes.
+
+   The kernel writes straight from the caller's pages, a page at
+   a time, so the cost per byte should level off once writes are
+   a few pages long, and large writes should not fail for lack of
+   kernel memory.
+
+   Usage: writebench */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <syscall.h>
+
+/* Size of the file written, which is also the largest write. */
+#define FILE_SIZE (256 * 1024)
+
+/* Passes over the file at each write size. */
+#define ITERATIONS 4
+
+/* Bytes written to the console at each size. */
+#define CONSOLE_BYTES 4096
+
+static char buf[FILE_SIZE];
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+int
+main (void)
+{
+  const char *file_name = "writebench.tmp";
+  uint64_t console_cycles[CONSOLE_BYTES / 512 + 1];
+  int write_size, fd, i, j;
+
+  for (i = 0; i < FILE_SIZE; i++)
+    buf[i] = i % 64 == 63 ? '\n' : 'a' + i % 26;
+
+  remove (file_name);
+  if (!create (file_name, FILE_SIZE))
+    {
+      printf ("%s: create failed\n", file_name);
+      return EXIT_FAILURE;
+    }
+  fd = open (file_name);
+  if (fd < 0)
+    {
+      printf ("%s: open failed\n", file_name);
+      return EXIT_FAILURE;
+    }
+
+  /* Time the console first, since its output gets in the way of
+     the table. */
+  for (write_size = 512, j = 0; write_size <= CONSOLE_BYTES;
+       write_size *= 2, j++)
+    {
+      uint64_t start = rdtsc ();
+      for (i = 0; i < CONSOLE_BYTES; i += write_size)
+        write (STDOUT_FILENO, buf, write_size);
+      console_cycles[j] = rdtsc () - start;
+    }
+
+  printf ("\n%10s %16s %16s\n", "size", "file cyc/KB", "console cyc/KB");
+  for (write_size = 512, j = 0; write_size <= FILE_SIZE;
+       write_size *= 2, j++)
+    {
+      uint64_t cycles = 0;
+      int pass;
+
+      for (pass = 0; pass < ITERATIONS; pass++)
+        {
+          uint64_t start;
+
+          seek (fd, 0);
+          start = rdtsc ();
+          for (i = 0; i < FILE_SIZE; i += write_size)
+            if (write (fd, buf + i, write_size) != write_size)
+              {
+                printf ("write of %d bytes failed\n", write_size);
+                return EXIT_FAILURE;
+              }
+          cycles += rdtsc () - start;
+        }
+
+      printf ("%10d %16llu", write_size,
+              cycles / ITERATIONS / (FILE_SIZE / 1024));
+      if (write_size <= CONSOLE_BYTES)
+        printf (" %16llu", console_cycles[j] / (CONSOLE_BYTES / 1024));
+      printf ("\n");
+    }
+
+  close (fd);
+  remove (file_name);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+/* writevbench.c
+
+   Compares writing records made of several pieces with one
+   write() per piece against one writev() per record.
+
+   Each record is a small header, a payload of varying size and
+   a small trailer, the way a log or a network message is often
+   assembled.  writev() validates the pieces once and takes the
+   file's locks once per record instead of once per piece, so it
+   should win by the most when payloads are small.
+
+   Usage: writevbench */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <syscall.h>
+
+/* Size of the file written. */
+#define FILE_SIZE (64 * 1024)
+
+/* Passes over the file at each payload size. */
+#define ITERATIONS 4
+
+/* Largest payload. */
+#define MAX_PAYLOAD 4096
+
+static char header[16] = "record header:\t";
+static char payload[MAX_PAYLOAD];
+static char trailer[4] = "end\n";
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Writes records with PAYLOAD_SIZE bytes of payload to FD until
+   the file is full, using writev() if VECTORED is true and
+   otherwise one write() per piece.  Returns the cycles taken,
+   or 0 on failure. */
+static uint64_t
+write_records (int fd, int payload_size, bool vectored)
+{
+  struct iovec iov[3] =
+    {
+      {header, sizeof header},
+      {payload, payload_size},
+      {trailer, sizeof trailer},
+    };
+  int record_size = sizeof header + payload_size + sizeof trailer;
+  uint64_t start;
+  int ofs;
+
+  seek (fd, 0);
+  start = rdtsc ();
+  for (ofs = 0; ofs + record_size <= FILE_SIZE; ofs += record_size)
+    if (vectored)
+      {
+        if (writev (fd, iov, 3) != record_size)
+          return 0;
+      }
+    else
+      {
+        int i;
+        for (i = 0; i < 3; i++)
+          if (write (fd, iov[i].iov_base, iov[i].iov_len)
+              != (int) iov[i].iov_len)
+            return 0;
+      }
+  return rdtsc () - start;
+}
+
+int
+main (void)
+{
+  const char *file_name = "writevbench.tmp";
+  int payload_size, fd, i;
+
+  for (i = 0; i < MAX_PAYLOAD; i++)
+    payload[i] = 'a' + i % 26;
+
+  remove (file_name);
+  if (!create (file_name, FILE_SIZE))
+    {
+      printf ("%s: create failed\n", file_name);
+      return EXIT_FAILURE;
+    }
+  fd = open (file_name);
+  if (fd < 0)
+    {
+      printf ("%s: open failed\n", file_name);
+      return EXIT_FAILURE;
+    }
+
+  printf ("%10s %16s %16s\n", "payload", "write cyc/rec", "writev cyc/rec");
+  for (payload_size = 16; payload_size <= MAX_PAYLOAD; payload_size *= 4)
+    {
+      int record_cnt = (FILE_SIZE
+                        / (sizeof header + payload_size + sizeof trailer));
+      uint64_t cycles[2] = {0, 0};
+      int pass, vectored;
+
+      for (pass = 0; pass < ITERATIONS; pass++)
+        for (vectored = 0; vectored < 2; vectored++)
+          {
+            uint64_t c = write_records (fd, payload_size, vectored);
+            if (c == 0)
+              {
+                printf ("%s of %d-byte records failed\n",
+                        vectored ? "writev" : "write", payload_size);
+                return EXIT_FAILURE;
+              }
+            cycles[vectored] += c;
+          }
+
+      printf ("%10d %16llu %16llu\n", payload_size,
+              cycles[0] / ITERATIONS / record_cnt,
+              cycles[1] / ITERATIONS / record_cnt);
+    }
+
+  close (fd);
+  remove (file_name);
+  return EXIT_SUCCESS;
+}
@@ -2,11 +2,13 @@
 #include <debug.h>
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* An open file. */
 struct file 
   {
     struct inode *inode;        /* File's inode. */
+    struct lock lock;           /* Protects POS and DENY_WRITE. */
     off_t pos;                  /* Current position. */
     bool deny_write;            /* Has file_deny_write() been called? */
   };
@@ -21,6 +23,7 @@ file_open (struct inode *inode)
   if (inode != NULL && file != NULL)
     {
       file->inode = inode;
+      lock_init (&file->lock);
       file->pos = 0;
       file->deny_write = false;
       return file;
@@ -68,8 +71,12 @@ file_get_inode (struct file *file)
 off_t
 file_read (struct file *file, void *buffer, off_t size) 
 {
-  off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
+  off_t bytes_read;
+
+  lock_acquire (&file->lock);
+  bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
   file->pos += bytes_read;
+  lock_release (&file->lock);
   return bytes_read;
 }
 
@@ -94,8 +101,12 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs)
 off_t
 file_write (struct file *file, const void *buffer, off_t size) 
 {
-  off_t bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
+  off_t bytes_written;
+
+  lock_acquire (&file->lock);
+  bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
   file->pos += bytes_written;
+  lock_release (&file->lock);
   return bytes_written;
 }
 
@@ -113,17 +124,83 @@ file_write_at (struct file *file, const void *buffer, off_t size,
   return inode_write_at (file->inode, buffer, size, file_ofs);
 }
 
+/* Reads into the CNT buffers in IOV, in order, from FILE,
+   starting at the file's current position.
+   Returns the number of bytes actually read,
+   which may be less than requested if end of file is reached.
+   Advances FILE's position by the number of bytes read. */
+off_t
+file_readv (struct file *file, const struct iovec *iov, int cnt)
+{
+  off_t bytes_read;
+
+  lock_acquire (&file->lock);
+  bytes_read = inode_readv_at (file->inode, iov, cnt, file->pos);
+  file->pos += bytes_read;
+  lock_release (&file->lock);
+  return bytes_read;
+}
+
+/* Writes the CNT buffers in IOV, in order, into FILE, starting
+   at the file's current position, as a single write.
+   Returns the number of bytes actually written,
+   which may be less than requested if end of file is reached.
+   Advances FILE's position by the number of bytes written. */
+off_t
+file_writev (struct file *file, const struct iovec *iov, int cnt)
+{
+  off_t bytes_written;
+
+  lock_acquire (&file->lock);
+  bytes_written = inode_writev_at (file->inode, iov, cnt, file->pos);
+  file->pos += bytes_written;
+  lock_release (&file->lock);
+  return bytes_written;
+}
+
+/* Copies SIZE bytes from SRC, starting at its current position,
+   into DST, starting at its current position, entirely within
+   the file system.
+   Returns the number of bytes actually copied,
+   which may be less than SIZE if end of either file is reached.
+   Advances both files' positions by the number of bytes copied.
+   Copies nothing if SRC and DST are the same file. */
+off_t
+file_copy (struct file *dst, struct file *src, off_t size)
+{
+  /* Lock the two files in a fixed order, so that two opposite
+     copies cannot deadlock. */
+  struct file *first = dst < src ? dst : src;
+  struct file *second = dst < src ? src : dst;
+  off_t bytes_copied;
+
+  if (dst == src)
+    return 0;
+
+  lock_acquire (&first->lock);
+  lock_acquire (&second->lock);
+  bytes_copied = inode_copy_at (dst->inode, dst->pos,
+                                src->inode, src->pos, size);
+  dst->pos += bytes_copied;
+  src->pos += bytes_copied;
+  lock_release (&second->lock);
+  lock_release (&first->lock);
+  return bytes_copied;
+}
+
 /* Prevents write operations on FILE's underlying inode
    until file_allow_write() is called or FILE is closed. */
 void
 file_deny_write (struct file *file) 
 {
   ASSERT (file != NULL);
+  lock_acquire (&file->lock);
   if (!file->deny_write) 
     {
       file->deny_write = true;
       inode_deny_write (file->inode);
     }
+  lock_release (&file->lock);
 }
 
 /* Re-enables write operations on FILE's underlying inode.
@@ -133,11 +210,13 @@ void
 file_allow_write (struct file *file) 
 {
   ASSERT (file != NULL);
+  lock_acquire (&file->lock);
   if (file->deny_write) 
     {
       file->deny_write = false;
       inode_allow_write (file->inode);
     }
+  lock_release (&file->lock);
 }
 
 /* Returns the size of FILE in bytes. */
@@ -155,7 +234,9 @@ file_seek (struct file *file, off_t new_pos)
 {
   ASSERT (file != NULL);
   ASSERT (new_pos >= 0);
+  lock_acquire (&file->lock);
   file->pos = new_pos;
+  lock_release (&file->lock);
 }
 
 /* Returns the current position in FILE as a byte offset from the
@@ -163,6 +244,11 @@ file_seek (struct file *file, off_t new_pos)
 off_t
 file_tell (struct file *file) 
 {
+  off_t pos;
+
   ASSERT (file != NULL);
-  return file->pos;
+  lock_acquire (&file->lock);
+  pos = file->pos;
+  lock_release (&file->lock);
+  return pos;
 }
@@ -23,6 +23,7 @@ filesys_init (bool format)
 
   inode_init ();
   free_map_init ();
+  dir_init ();
 
   if (format) 
     do_format ();
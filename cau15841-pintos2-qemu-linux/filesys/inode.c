@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -28,12 +29,19 @@ bytes_to_sectors (off_t size)
   return DIV_ROUND_UP (size, BLOCK_SECTOR_SIZE);
 }
 
-/* In-memory inode. */
+/* In-memory inode.
+
+   ELEM and OPEN_CNT are protected by OPEN_INODES_LOCK, the rest
+   by the inode's own LOCK, which writers also hold for the whole
+   write so that their read-modify-write of partial sectors does
+   not lose data.  Readers take no lock: an inode's length and
+   sectors never change while it is open. */
 struct inode 
   {
     struct list_elem elem;              /* Element in inode list. */
     block_sector_t sector;              /* Sector number of disk location. */
     int open_cnt;                       /* Number of openers. */
+    struct lock lock;                   /* Protects the members below. */
     bool removed;                       /* True if deleted, false otherwise. */
     int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
     struct inode_disk data;             /* Inode content. */
@@ -53,15 +61,22 @@ byte_to_sector (const struct inode *inode, off_t pos)
     return -1;
 }
 
+static off_t write_at (struct inode *, const void *, off_t size,
+                       off_t offset);
+
 /* List of open inodes, so that opening a single inode twice
    returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Protects OPEN_INODES and the inodes' OPEN_CNT. */
+static struct lock open_inodes_lock;
+
 /* Initializes the inode module. */
 void
 inode_init (void) 
 {
   list_init (&open_inodes);
+  lock_init (&open_inodes_lock);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -114,6 +129,8 @@ inode_open (block_sector_t sector)
   struct list_elem *e;
   struct inode *inode;
 
+  lock_acquire (&open_inodes_lock);
+
   /* Check whether this inode is already open. */
   for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
        e = list_next (e)) 
@@ -121,7 +138,13 @@ inode_open (block_sector_t sector)
       inode = list_entry (e, struct inode, elem);
       if (inode->sector == sector) 
         {
-          inode_reopen (inode);
+          inode->open_cnt++;
+          lock_release (&open_inodes_lock);
+
+          /* Wait for whoever opened it first to finish reading
+             it in. */
+          lock_acquire (&inode->lock);
+          lock_release (&inode->lock);
           return inode; 
         }
     }
@@ -129,15 +152,27 @@ inode_open (block_sector_t sector)
   /* Allocate memory. */
   inode = malloc (sizeof *inode);
   if (inode == NULL)
-    return NULL;
+    {
+      lock_release (&open_inodes_lock);
+      return NULL;
+    }
 
-  /* Initialize. */
+  /* Initialize.  The inode goes on the list with its own lock
+     held, and is read from disk after the list lock is released,
+     so that opens of other inodes need not wait for the disk,
+     while other opens of this one wait above until it has been
+     read. */
   list_push_front (&open_inodes, &inode->elem);
   inode->sector = sector;
   inode->open_cnt = 1;
+  lock_init (&inode->lock);
   inode->deny_write_cnt = 0;
   inode->removed = false;
+  lock_acquire (&inode->lock);
+  lock_release (&open_inodes_lock);
+
   block_read (fs_device, inode->sector, &inode->data);
+  lock_release (&inode->lock);
   return inode;
 }
 
@@ -146,7 +181,11 @@ struct inode *
 inode_reopen (struct inode *inode)
 {
   if (inode != NULL)
-    inode->open_cnt++;
+    {
+      lock_acquire (&open_inodes_lock);
+      inode->open_cnt++;
+      lock_release (&open_inodes_lock);
+    }
   return inode;
 }
 
@@ -163,16 +202,22 @@ inode_get_inumber (const struct inode *inode)
 void
 inode_close (struct inode *inode) 
 {
+  bool last;
+
   /* Ignore null pointer. */
   if (inode == NULL)
     return;
 
+  /* Remove from inode list if this was the last opener. */
+  lock_acquire (&open_inodes_lock);
+  last = --inode->open_cnt == 0;
+  if (last)
+    list_remove (&inode->elem);
+  lock_release (&open_inodes_lock);
+
   /* Release resources if this was the last opener. */
-  if (--inode->open_cnt == 0)
+  if (last)
     {
-      /* Remove from inode list and release lock. */
-      list_remove (&inode->elem);
- 
       /* Deallocate blocks if removed. */
       if (inode->removed) 
         {
@@ -191,7 +236,9 @@ void
 inode_remove (struct inode *inode) 
 {
   ASSERT (inode != NULL);
+  lock_acquire (&inode->lock);
   inode->removed = true;
+  lock_release (&inode->lock);
 }
 
 /* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
@@ -249,21 +296,84 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
   return bytes_read;
 }
 
+/* Reads into the CNT buffers in IOV, in order, from INODE,
+   starting at position OFFSET.  Returns the number of bytes
+   actually read, which may be less than the buffers' total
+   length if an error occurs or end of file is reached. */
+off_t
+inode_readv_at (struct inode *inode, const struct iovec *iov, int cnt,
+                off_t offset)
+{
+  off_t bytes_read = 0;
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    {
+      off_t chunk = inode_read_at (inode, iov[i].iov_base, iov[i].iov_len,
+                                   offset + bytes_read);
+      bytes_read += chunk;
+      if (chunk < (off_t) iov[i].iov_len)
+        break;
+    }
+  return bytes_read;
+}
+
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
    Returns the number of bytes actually written, which may be
    less than SIZE if end of file is reached or an error occurs.
    (Normally a write at end of file would extend the inode, but
    growth is not yet implemented.) */
 off_t
-inode_write_at (struct inode *inode, const void *buffer_, off_t size,
+inode_write_at (struct inode *inode, const void *buffer, off_t size,
                 off_t offset) 
+{
+  off_t bytes_written = 0;
+
+  lock_acquire (&inode->lock);
+  if (!inode->deny_write_cnt)
+    bytes_written = write_at (inode, buffer, size, offset);
+  lock_release (&inode->lock);
+  return bytes_written;
+}
+
+/* Writes the CNT buffers in IOV, in order, into INODE, starting
+   at OFFSET, as a single write: no other write to INODE can come
+   in between.  Returns the number of bytes actually written,
+   which may be less than the buffers' total length if end of
+   file is reached or an error occurs. */
+off_t
+inode_writev_at (struct inode *inode, const struct iovec *iov, int cnt,
+                 off_t offset)
+{
+  off_t bytes_written = 0;
+  int i;
+
+  lock_acquire (&inode->lock);
+  if (!inode->deny_write_cnt)
+    for (i = 0; i < cnt; i++)
+      {
+        off_t chunk = write_at (inode, iov[i].iov_base, iov[i].iov_len,
+                                offset + bytes_written);
+        bytes_written += chunk;
+        if (chunk < (off_t) iov[i].iov_len)
+          break;
+      }
+  lock_release (&inode->lock);
+  return bytes_written;
+}
+
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET,
+   as inode_write_at() does.  INODE's lock must be held and
+   writes to it must be allowed. */
+static off_t
+write_at (struct inode *inode, const void *buffer_, off_t size,
+          off_t offset)
 {
   const uint8_t *buffer = buffer_;
   off_t bytes_written = 0;
   uint8_t *bounce = NULL;
 
-  if (inode->deny_write_cnt)
-    return 0;
+  ASSERT (lock_held_by_current_thread (&inode->lock));
 
   while (size > 0) 
     {
@@ -317,13 +427,81 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
   return bytes_written;
 }
 
+/* Copies SIZE bytes from SRC, starting at SRC_OFS, into DST,
+   starting at DST_OFS, a sector at a time, without the data
+   passing through a caller's buffer.  No other write to DST can
+   come in between.  Returns the number of bytes actually copied,
+   which may be less than SIZE if end of either file is reached
+   or an error occurs, or 0 if the two ranges overlap within one
+   inode. */
+off_t
+inode_copy_at (struct inode *dst, off_t dst_ofs,
+               struct inode *src, off_t src_ofs, off_t size)
+{
+  off_t bytes_copied = 0;
+  uint8_t *bounce;
+
+  /* Files do not grow, so nothing past the end of either can be
+     copied.  Trimming SIZE first also keeps the offset sums
+     below from overflowing. */
+  if (size > inode_length (src) - src_ofs)
+    size = inode_length (src) - src_ofs;
+  if (size > inode_length (dst) - dst_ofs)
+    size = inode_length (dst) - dst_ofs;
+  if (size <= 0
+      || (dst == src && src_ofs < dst_ofs + size && dst_ofs < src_ofs + size))
+    return 0;
+  bounce = malloc (BLOCK_SECTOR_SIZE);
+  if (bounce == NULL)
+    return 0;
+
+  lock_acquire (&dst->lock);
+  if (!dst->deny_write_cnt)
+    while (size > 0)
+      {
+        /* Source sector to read, starting byte offset within it. */
+        block_sector_t sector_idx = byte_to_sector (src, src_ofs);
+        int sector_ofs = src_ofs % BLOCK_SECTOR_SIZE;
+
+        /* Bytes left in SRC, bytes left in sector, lesser of the
+           two. */
+        off_t inode_left = inode_length (src) - src_ofs;
+        int sector_left = BLOCK_SECTOR_SIZE - sector_ofs;
+        int min_left = inode_left < sector_left ? inode_left : sector_left;
+
+        /* Number of bytes to copy out of this sector. */
+        int chunk_size = size < min_left ? size : min_left;
+        off_t chunk_written;
+        if (chunk_size <= 0)
+          break;
+
+        block_read (fs_device, sector_idx, bounce);
+        chunk_written = write_at (dst, bounce + sector_ofs, chunk_size,
+                                  dst_ofs);
+
+        /* Advance. */
+        size -= chunk_written;
+        src_ofs += chunk_written;
+        dst_ofs += chunk_written;
+        bytes_copied += chunk_written;
+        if (chunk_written < chunk_size)
+          break;
+      }
+  lock_release (&dst->lock);
+  free (bounce);
+
+  return bytes_copied;
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 void
 inode_deny_write (struct inode *inode) 
 {
+  lock_acquire (&inode->lock);
   inode->deny_write_cnt++;
   ASSERT (inode->deny_write_cnt <= inode->open_cnt);
+  lock_release (&inode->lock);
 }
 
 /* Re-enables writes to INODE.
@@ -332,9 +510,11 @@ inode_deny_write (struct inode *inode)
 void
 inode_allow_write (struct inode *inode) 
 {
+  lock_acquire (&inode->lock);
   ASSERT (inode->deny_write_cnt > 0);
   ASSERT (inode->deny_write_cnt <= inode->open_cnt);
   inode->deny_write_cnt--;
+  lock_release (&inode->lock);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
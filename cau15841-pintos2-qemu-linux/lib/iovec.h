@@ -0,0 +1,19 @@
+#ifndef __LIB_IOVEC_H
+#define __LIB_IOVEC_H
+
+/* Buffers for vectored I/O, shared between the kernel and user
+   programs through the readv and writev system calls. */
+
+#include <stddef.h>
+
+/* One buffer. */
+struct iovec
+  {
+    void *iov_base;             /* Start of the buffer. */
+    size_t iov_len;             /* Length of the buffer in bytes. */
+  };
+
+/* Most buffers that one readv() or writev() may name. */
+#define IOV_MAX 64
+
+#endif /* lib/iovec.h */
@@ -0,0 +1,96 @@
+#ifndef __LIB_MEMSTAT_H
+#define __LIB_MEMSTAT_H
+
+/* Memory statistics shared between the kernel and user programs
+   through the memstat system call. */
+
+#include <stdint.h>
+
+/* Page allocator pools. */
+enum memstat_pool
+  {
+    MEMSTAT_KERNEL,             /* Kernel pool. */
+    MEMSTAT_USER,               /* User pool. */
+    MEMSTAT_POOL_CNT
+  };
+
+/* Number of page allocator policies (see threads/palloc.h). */
+#define MEMSTAT_POLICY_CNT 2
+
+/* Counters for one allocation policy within a pool. */
+struct palloc_policy_stats
+  {
+    uint64_t scan_cnt;          /* Bitmap scans performed. */
+    uint64_t wrap_cnt;          /* Scans restarted from page 0. */
+    uint64_t fail_cnt;          /* Scans that found no free run. */
+  };
+
+/* Page allocator statistics for one pool.  The first group is
+   computed when the statistics are sampled; the rest are running
+   totals since boot. */
+struct palloc_stats
+  {
+    uint32_t page_cnt;          /* Pages managed by the pool. */
+    uint32_t used_cnt;          /* Pages currently allocated. */
+    uint32_t peak_used_cnt;     /* Highest USED_CNT seen. */
+    uint32_t zeroed_cnt;        /* Free pages waiting pre-zeroed. */
+    uint32_t largest_free_run;  /* Longest run of free pages,
+                                   including zeroed ones. */
+    uint32_t policy;            /* Active allocation policy. */
+
+    uint64_t alloc_cnt;         /* Successful allocations. */
+    uint64_t alloc_pages;       /* Pages handed out by them. */
+    uint64_t free_cnt;          /* Calls to palloc_free_*(). */
+    uint64_t free_pages;        /* Pages returned by them. */
+    uint64_t fail_cnt;          /* Allocations that returned null. */
+    uint64_t zero_hit_cnt;      /* PAL_ZERO served without memset. */
+    uint64_t lock_cnt;          /* Times the pool lock was taken. */
+    uint64_t lock_cycles;       /* CPU cycles spent holding it. */
+    struct palloc_policy_stats policies[MEMSTAT_POLICY_CNT];
+  };
+
+/* Memory charged to one process, returned by the memusage
+   system call.  Kernel pages and heap bytes are charged to the
+   process that allocated them until they are freed, whichever
+   process frees them.  Page table pages and the pages holding
+   small heap blocks are not counted among the kernel pages. */
+struct proc_memstat
+  {
+    uint32_t user_pages;        /* Resident user pages. */
+    uint32_t peak_user_pages;   /* Highest USER_PAGES seen. */
+    uint32_t user_page_limit;   /* Most resident user pages allowed. */
+    uint32_t reclaim_cnt;       /* Own pages evicted to stay in limit. */
+    uint32_t pt_pages;          /* Page directory and page tables. */
+    uint32_t kernel_pages;      /* Kernel pool pages. */
+    uint32_t heap_bytes;        /* Kernel heap bytes. */
+  };
+
+/* USER_PAGE_LIMIT of a process with no limit. */
+#define MEMSTAT_NO_LIMIT UINT32_MAX
+
+/* Resident pages accessed within this many samples are in a
+   process's working set. */
+#define WSSTAT_WINDOW 4
+
+/* Number of buckets in the idle age histogram. */
+#define WSSTAT_AGE_CNT 7
+
+/* Working-set estimate for one process, returned by the wsstat
+   system call.  A kernel thread samples and clears the accessed
+   bits of every process's resident pages every SAMPLE_MS
+   milliseconds; a page's idle age is the number of samples since
+   its accessed bit was last seen set.  The other counters are as
+   of the latest sample. */
+struct proc_wsstat
+  {
+    uint32_t sample_ms;         /* Sampling period. */
+    uint32_t sample_cnt;        /* Samples taken of this process. */
+    uint32_t resident_pages;    /* Resident user pages. */
+    uint32_t ws_pages;          /* Pages idle fewer than WSSTAT_WINDOW
+                                   samples. */
+    uint32_t age_hist[WSSTAT_AGE_CNT]; /* Resident pages idle for 0, 1,
+                                          2-3, 4-7, 8-15, 16-31 and
+                                          32 or more samples. */
+  };
+
+#endif /* lib/memstat.h */
@@ -0,0 +1,50 @@
+#ifndef __LIB_RING_H
+#define __LIB_RING_H
+
+/* A submission queue and a completion queue through which a user
+   program hands the kernel a batch of system calls at once, with
+   a single ring_enter() system call.
+
+   The program fills in entries at SQ_TAIL and advances it; the
+   kernel carries out entries from SQ_HEAD up to SQ_TAIL, in
+   order, advancing SQ_HEAD past each, and posts each one's result
+   at CQ_TAIL.  The program reads results from CQ_HEAD and
+   advances it.  Indexes run freely and are reduced modulo
+   RING_ENTRIES to find a slot.
+
+   Only file system calls, which neither end nor replace the
+   process, may be submitted; any other completes with -1.  A bad
+   argument kills the process, as it would for a direct call. */
+
+#include <stdint.h>
+
+/* Slots in each queue.  A power of 2. */
+#define RING_ENTRIES 64
+
+/* A submitted system call. */
+struct ring_sqe
+  {
+    int32_t number;             /* System call number, SYS_*. */
+    int32_t args[4];            /* Arguments. */
+    uint32_t user_data;         /* Copied to the completion. */
+  };
+
+/* A completed system call. */
+struct ring_cqe
+  {
+    int32_t result;             /* Return value. */
+    uint32_t user_data;         /* From the submission. */
+  };
+
+/* A submission and completion queue pair. */
+struct ring
+  {
+    uint32_t sq_head;           /* Next entry to run.  Kernel writes. */
+    uint32_t sq_tail;           /* Next free entry.  Program writes. */
+    uint32_t cq_head;           /* Next result to read.  Program writes. */
+    uint32_t cq_tail;           /* Next result slot.  Kernel writes. */
+    struct ring_sqe sq[RING_ENTRIES];
+    struct ring_cqe cq[RING_ENTRIES];
+  };
+
+#endif /* lib/ring.h */
@@ -28,7 +28,34 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Memory statistics. */
+    SYS_MEMSTAT,                /* Samples page allocator statistics. */
+
+    /* Copy-on-write process creation. */
+    SYS_FORK,                   /* Duplicate the calling process. */
+
+    /* Per-process memory accounting. */
+    SYS_MEMUSAGE,               /* Report memory charged to the process. */
+    SYS_MEMLIMIT,               /* Limit memory of new child processes. */
+
+    /* Working-set estimation. */
+    SYS_WSSTAT,                 /* Report the process's working set. */
+
+    /* Vectored I/O. */
+    SYS_READV,                  /* Read into several buffers. */
+    SYS_WRITEV,                 /* Write from several buffers. */
+
+    /* Positional I/O. */
+    SYS_PREAD,                  /* Read at an offset. */
+    SYS_PWRITE,                 /* Write at an offset. */
+
+    /* Batched system calls. */
+    SYS_RING_ENTER,             /* Run the calls queued in a ring. */
+
+    /* In-kernel file copy. */
+    SYS_COPY_FILE_RANGE         /* Copy bytes from one file to another. */
   };
 
 #endif /* lib/syscall-nr.h */
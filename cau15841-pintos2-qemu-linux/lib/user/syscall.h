@@ -3,6 +3,9 @@
 
 #include <stdbool.h>
 #include <debug.h>
+#include <iovec.h>
+#include <memstat.h>
+#include <ring.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -45,4 +48,31 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Memory statistics. */
+bool memstat (enum memstat_pool, struct palloc_stats *);
+
+/* Copy-on-write process creation. */
+pid_t fork (void);
+
+/* Per-process memory accounting. */
+bool memusage (struct proc_memstat *);
+void memlimit (unsigned page_cnt);
+
+/* Working-set estimation. */
+bool wsstat (struct proc_wsstat *);
+
+/* Vectored I/O. */
+int readv (int fd, const struct iovec *, int iovcnt);
+int writev (int fd, const struct iovec *, int iovcnt);
+
+/* Positional I/O. */
+int pread (int fd, void *buffer, unsigned length, int offset);
+int pwrite (int fd, const void *buffer, unsigned length, int offset);
+
+/* Batched system calls. */
+int ring_enter (struct ring *);
+
+/* In-kernel file copy. */
+int copy_file_range (int fd_in, int fd_out, unsigned length);
+
 #endif /* lib/user/syscall.h */
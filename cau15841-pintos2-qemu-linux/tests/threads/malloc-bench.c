@@ -0,0 +1,98 @@
+/* Measures malloc() and free() throughput.  The first phase
+   repeatedly allocates and immediately frees blocks of mixed
+   sizes, the common pattern for short-lived kernel buffers.  The
+   second keeps a random working set of blocks alive, replacing a
+   random one each iteration.  The third runs the second phase in
+   several threads at once, so that they compete for the
+   allocator.  Timings are reported in timer ticks; the test
+   itself only checks that every allocation succeeds. */
+
+#include <stdio.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Request sizes to mix.  The last one is a multi-page block. */
+static const size_t sizes[] = {8, 24, 40, 100, 200, 500, 900, 3000};
+#define SIZE_CNT (sizeof sizes / sizeof *sizes)
+
+#define PAIR_ITERATIONS 200000  /* Alloc/free pairs in phase 1. */
+#define SET_ITERATIONS 100000   /* Replacements in phases 2 and 3. */
+#define SET_SIZE 256            /* Live blocks in phases 2 and 3. */
+#define THREAD_CNT 4            /* Threads in phase 3. */
+
+static void run_working_set (void *);
+
+void
+test_malloc_bench (void) 
+{
+  struct semaphore done;
+  int64_t start;
+  int i;
+
+  /* Phase 1: back-to-back allocation and release. */
+  start = timer_ticks ();
+  for (i = 0; i < PAIR_ITERATIONS; i++) 
+    {
+      void *p = malloc (sizes[i % SIZE_CNT]);
+      if (p == NULL)
+        fail ("malloc failed at pair %d", i);
+      free (p);
+    }
+  msg ("%d alloc/free pairs: %lld ticks",
+       PAIR_ITERATIONS, timer_elapsed (start));
+
+  /* Phase 2: random working set, one thread. */
+  start = timer_ticks ();
+  run_working_set (NULL);
+  msg ("%d working-set replacements: %lld ticks",
+       SET_ITERATIONS, timer_elapsed (start));
+
+  /* Phase 3: random working set, several threads. */
+  sema_init (&done, 0);
+  start = timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "bench %d", i);
+      thread_create (name, PRI_DEFAULT, run_working_set, &done);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  msg ("%d threads x %d working-set replacements: %lld ticks",
+       THREAD_CNT, SET_ITERATIONS, timer_elapsed (start));
+}
+
+/* Keeps SET_SIZE blocks of random sizes allocated, freeing and
+   reallocating a random one SET_ITERATIONS times, then frees
+   them all.  Ups DONE_, if nonnull, when finished. */
+static void
+run_working_set (void *done_) 
+{
+  struct semaphore *done = done_;
+  void **set;
+  int i;
+
+  set = calloc (SET_SIZE, sizeof *set);
+  if (set == NULL)
+    fail ("out of memory for working set");
+
+  for (i = 0; i < SET_ITERATIONS; i++) 
+    {
+      size_t slot = random_ulong () % SET_SIZE;
+      free (set[slot]);
+      set[slot] = malloc (sizes[random_ulong () % SIZE_CNT]);
+      if (set[slot] == NULL)
+        fail ("malloc failed at replacement %d", i);
+    }
+
+  for (i = 0; i < SET_SIZE; i++)
+    free (set[i]);
+  free (set);
+
+  if (done != NULL)
+    sema_up (done);
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+fail "missing 'begin' message\n"
+  if !grep ($_ eq '(malloc-bench) begin', @output);
+fail "missing 'end' message\n"
+  if !grep ($_ eq '(malloc-bench) end', @output);
+pass;
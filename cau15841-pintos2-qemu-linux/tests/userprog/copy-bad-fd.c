@@ -0,0 +1,24 @@
+/* Tries copy_file_range() with an invalid fd, or the console,
+   on either side.  Each must return -1. */
+
+#include <limits.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (copy_file_range (handle, 7, 1) == -1, "copy to bad fd");
+  CHECK (copy_file_range (2546, handle, 1) == -1, "copy from bad fd");
+  CHECK (copy_file_range (INT_MIN + 1, INT_MAX - 1, 1) == -1,
+         "copy between bad fds");
+  CHECK (copy_file_range (handle, STDOUT_FILENO, 1) == -1,
+         "copy to stdout");
+  CHECK (copy_file_range (STDIN_FILENO, handle, 1) == -1,
+         "copy from stdin");
+}
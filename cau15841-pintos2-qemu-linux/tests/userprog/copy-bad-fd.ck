@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-bad-fd) begin
+(copy-bad-fd) open "sample.txt"
+(copy-bad-fd) copy to bad fd
+(copy-bad-fd) copy from bad fd
+(copy-bad-fd) copy between bad fds
+(copy-bad-fd) copy to stdout
+(copy-bad-fd) copy from stdin
+(copy-bad-fd) end
+copy-bad-fd: exit(0)
+EOF
+pass;
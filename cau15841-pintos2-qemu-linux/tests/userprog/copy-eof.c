@@ -0,0 +1,44 @@
+/* Copies with copy_file_range() across the end of the source
+   file, then across the end of the destination file.  Each copy
+   must stop at the end of file, return the number of bytes
+   copied, and advance both positions by that much. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SAMPLE_SIZE ((int) sizeof sample - 1)
+
+static char buf[sizeof sample];
+
+void
+test_main (void) 
+{
+  int src, dst;
+
+  CHECK (create ("copy", SAMPLE_SIZE), "create \"copy\"");
+  CHECK ((src = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((dst = open ("copy")) > 1, "open \"copy\"");
+
+  /* Only 10 bytes are left in the source. */
+  seek (src, SAMPLE_SIZE - 10);
+  CHECK (copy_file_range (src, dst, 100) == 10,
+         "copy past end of \"sample.txt\"");
+  CHECK (tell (src) == SAMPLE_SIZE && tell (dst) == 10,
+         "positions advanced by 10");
+  CHECK (copy_file_range (src, dst, 100) == 0,
+         "copy from end of \"sample.txt\"");
+
+  /* Only 5 bytes are left in the destination. */
+  seek (src, 0);
+  seek (dst, SAMPLE_SIZE - 5);
+  CHECK (copy_file_range (src, dst, 100) == 5, "copy past end of \"copy\"");
+  CHECK (tell (src) == 5 && tell (dst) == SAMPLE_SIZE,
+         "positions advanced by 5");
+
+  seek (dst, 0);
+  CHECK (read (dst, buf, SAMPLE_SIZE) == SAMPLE_SIZE, "read \"copy\"");
+  compare_bytes (buf, sample + SAMPLE_SIZE - 10, 10, 0, "copy");
+  compare_bytes (buf + SAMPLE_SIZE - 5, sample, 5, SAMPLE_SIZE - 5, "copy");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-eof) begin
+(copy-eof) create "copy"
+(copy-eof) open "sample.txt"
+(copy-eof) open "copy"
+(copy-eof) copy past end of "sample.txt"
+(copy-eof) positions advanced by 10
+(copy-eof) copy from end of "sample.txt"
+(copy-eof) copy past end of "copy"
+(copy-eof) positions advanced by 5
+(copy-eof) read "copy"
+(copy-eof) end
+copy-eof: exit(0)
+EOF
+pass;
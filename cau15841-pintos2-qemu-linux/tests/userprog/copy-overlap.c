@@ -0,0 +1,30 @@
+/* Opens "sample.txt" twice and tries copy_file_range() between
+   overlapping ranges of the file, and from a file to itself.
+   Both must copy nothing and leave the file unchanged. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[sizeof sample];
+
+void
+test_main (void) 
+{
+  int src, dst;
+
+  CHECK ((src = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((dst = open ("sample.txt")) > 1, "open \"sample.txt\" again");
+  seek (dst, 10);
+  CHECK (copy_file_range (src, dst, 20) == 0,
+         "copy overlapping range (must copy nothing)");
+  CHECK (copy_file_range (src, src, 20) == 0,
+         "copy file onto itself (must copy nothing)");
+  CHECK (tell (src) == 0 && tell (dst) == 10, "positions unchanged");
+
+  CHECK (read (src, buf, sizeof sample - 1) == (int) sizeof sample - 1,
+         "read \"sample.txt\"");
+  compare_bytes (buf, sample, sizeof sample - 1, 0, "sample.txt");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-overlap) begin
+(copy-overlap) open "sample.txt"
+(copy-overlap) open "sample.txt" again
+(copy-overlap) copy overlapping range (must copy nothing)
+(copy-overlap) copy file onto itself (must copy nothing)
+(copy-overlap) positions unchanged
+(copy-overlap) read "sample.txt"
+(copy-overlap) end
+copy-overlap: exit(0)
+EOF
+pass;
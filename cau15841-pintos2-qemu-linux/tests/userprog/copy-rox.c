@@ -0,0 +1,25 @@
+/* Ensures that copy_file_range() cannot modify the executable
+   of a running process. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char before[16], after[16];
+  int src, exe;
+
+  CHECK ((src = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((exe = open ("copy-rox")) > 1, "open \"copy-rox\"");
+  CHECK (read (exe, before, sizeof before) == (int) sizeof before,
+         "read \"copy-rox\"");
+  seek (exe, 0);
+  CHECK (copy_file_range (src, exe, sizeof before) == 0,
+         "try to copy onto \"copy-rox\"");
+  CHECK (tell (src) == 0 && tell (exe) == 0, "positions unchanged");
+  CHECK (read (exe, after, sizeof after) == (int) sizeof after,
+         "read \"copy-rox\" again");
+  compare_bytes (after, before, sizeof after, 0, "copy-rox");
+}
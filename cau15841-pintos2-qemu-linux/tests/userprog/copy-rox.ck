@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-rox) begin
+(copy-rox) open "sample.txt"
+(copy-rox) open "copy-rox"
+(copy-rox) read "copy-rox"
+(copy-rox) try to copy onto "copy-rox"
+(copy-rox) positions unchanged
+(copy-rox) read "copy-rox" again
+(copy-rox) end
+copy-rox: exit(0)
+EOF
+pass;
@@ -0,0 +1,39 @@
+/* Reads and writes with pread() and pwrite(), which must leave
+   the file position alone, and passes them a negative offset
+   and the console fds, for which each must return -1. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SAMPLE_SIZE ((int) sizeof sample - 1)
+
+static char buf[sizeof sample];
+
+void
+test_main (void) 
+{
+  int handle;
+
+  CHECK (create ("data", SAMPLE_SIZE), "create \"data\"");
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+
+  seek (handle, 7);
+  CHECK (pwrite (handle, sample, SAMPLE_SIZE, 0) == SAMPLE_SIZE,
+         "pwrite \"data\"");
+  CHECK (tell (handle) == 7, "position unchanged by pwrite");
+  CHECK (pread (handle, buf, 20, 30) == 20, "pread \"data\"");
+  CHECK (tell (handle) == 7, "position unchanged by pread");
+  compare_bytes (buf, sample + 30, 20, 30, "data");
+
+  CHECK (read (handle, buf, 10) == 10, "read \"data\" at position");
+  compare_bytes (buf, sample + 7, 10, 7, "data");
+
+  CHECK (pread (handle, buf, 1, -1) == -1, "pread at negative offset");
+  CHECK (pwrite (handle, buf, 1, -1) == -1, "pwrite at negative offset");
+
+  CHECK (pread (STDIN_FILENO, buf, 1, 0) == -1, "pread from stdin");
+  CHECK (pwrite (STDOUT_FILENO, "x", 1, 0) == -1, "pwrite to stdout");
+}
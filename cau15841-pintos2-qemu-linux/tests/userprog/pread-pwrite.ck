@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) create "data"
+(pread-pwrite) open "data"
+(pread-pwrite) pwrite "data"
+(pread-pwrite) position unchanged by pwrite
+(pread-pwrite) pread "data"
+(pread-pwrite) position unchanged by pread
+(pread-pwrite) read "data" at position
+(pread-pwrite) pread at negative offset
+(pread-pwrite) pwrite at negative offset
+(pread-pwrite) pread from stdin
+(pread-pwrite) pwrite to stdout
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
@@ -0,0 +1,34 @@
+/* Reads "sample.txt" with readv() into buffers that share a page
+   and overlap each other, with empty buffers, one of them at a
+   null pointer, mixed in.  Empty buffers must be skipped without
+   being touched. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[32];
+
+void
+test_main (void) 
+{
+  struct iovec iov[] =
+    {
+      {buf + 1, 0},
+      {buf, 10},
+      {NULL, 0},
+      {buf + 5, 10},
+      {buf + 15, 0},
+    };
+  int handle, byte_cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  byte_cnt = readv (handle, iov, sizeof iov / sizeof *iov);
+  if (byte_cnt != 20)
+    fail ("readv() returned %d instead of 20", byte_cnt);
+
+  /* The second buffer overwrote the last 5 bytes of the first. */
+  compare_bytes (buf, sample, 5, 0, "sample.txt");
+  compare_bytes (buf + 5, sample + 10, 10, 10, "sample.txt");
+}
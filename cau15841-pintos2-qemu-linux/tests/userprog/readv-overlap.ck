@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-overlap) begin
+(readv-overlap) open "sample.txt"
+(readv-overlap) end
+readv-overlap: exit(0)
+EOF
+pass;
@@ -0,0 +1,33 @@
+/* Passes ring_enter() a ring whose submission or completion
+   queue holds more than RING_ENTRIES entries.  Each call must
+   return -1 without carrying out anything. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct ring ring;
+
+void
+test_main (void) 
+{
+  ring.sq[0].number = SYS_TELL;
+  ring.sq[0].args[0] = 0;
+
+  ring.sq_head = 0;
+  ring.sq_tail = RING_ENTRIES + 1;
+  CHECK (ring_enter (&ring) == -1, "ring_enter with overfull SQ");
+  CHECK (ring.sq_head == 0 && ring.cq_tail == 0, "indexes unchanged");
+
+  ring.sq_head = 5;
+  ring.sq_tail = 4;
+  CHECK (ring_enter (&ring) == -1, "ring_enter with SQ tail behind head");
+
+  ring.sq_head = 0;
+  ring.sq_tail = 1;
+  ring.cq_head = 10;
+  ring.cq_tail = 5;
+  CHECK (ring_enter (&ring) == -1, "ring_enter with CQ tail behind head");
+  CHECK (ring.sq_head == 0 && ring.cq_tail == 5, "indexes unchanged");
+}
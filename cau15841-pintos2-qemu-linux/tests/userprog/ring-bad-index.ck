@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-bad-index) begin
+(ring-bad-index) ring_enter with overfull SQ
+(ring-bad-index) indexes unchanged
+(ring-bad-index) ring_enter with SQ tail behind head
+(ring-bad-index) ring_enter with CQ tail behind head
+(ring-bad-index) indexes unchanged
+(ring-bad-index) end
+ring-bad-index: exit(0)
+EOF
+pass;
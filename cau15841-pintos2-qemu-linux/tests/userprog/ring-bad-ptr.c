@@ -0,0 +1,24 @@
+/* Submits a write with an invalid buffer through a ring.
+   The process must be terminated with -1 exit code. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct ring ring;
+
+void
+test_main (void) 
+{
+  int handle;
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  ring.sq[0].number = SYS_WRITE;
+  ring.sq[0].args[0] = handle;
+  ring.sq[0].args[1] = 0x10123420;
+  ring.sq[0].args[2] = 123;
+  ring.sq_tail = 1;
+  ring_enter (&ring);
+  fail ("should have exited with -1");
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-bad-ptr) begin
+(ring-bad-ptr) open "sample.txt"
+ring-bad-ptr: exit(-1)
+EOF
+pass;
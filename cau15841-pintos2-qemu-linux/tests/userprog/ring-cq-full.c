@@ -0,0 +1,50 @@
+/* Submits more calls than there is room for in the completion
+   queue.  ring_enter() must stop when the queue fills, leaving
+   the rest submitted, and carry them out once results have been
+   consumed. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct ring ring;
+
+void
+test_main (void) 
+{
+  int handle, size;
+  uint32_t i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  size = filesize (handle);
+
+  /* Leave room for only 4 results. */
+  ring.cq_head = 0;
+  ring.cq_tail = RING_ENTRIES - 4;
+  for (i = 0; i < 10; i++)
+    {
+      ring.sq[i].number = SYS_FILESIZE;
+      ring.sq[i].args[0] = handle;
+      ring.sq[i].user_data = i;
+    }
+  ring.sq_tail = 10;
+
+  CHECK (ring_enter (&ring) == 4, "ring_enter with 4 free CQ slots");
+  CHECK (ring.sq_head == 4 && ring.cq_tail == RING_ENTRIES,
+         "stopped when CQ full");
+  CHECK (ring_enter (&ring) == 0, "ring_enter with full CQ");
+
+  ring.cq_head = RING_ENTRIES;
+  CHECK (ring_enter (&ring) == 6, "ring_enter after consuming results");
+  CHECK (ring.sq_head == 10 && ring.cq_tail == RING_ENTRIES + 6,
+         "all calls completed");
+
+  for (i = 0; i < 10; i++)
+    {
+      struct ring_cqe *cqe = &ring.cq[(RING_ENTRIES - 4 + i) % RING_ENTRIES];
+      if (cqe->result != size || cqe->user_data != i)
+        fail ("completion %u: result %d, user data %u",
+              i, cqe->result, cqe->user_data);
+    }
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-cq-full) begin
+(ring-cq-full) open "sample.txt"
+(ring-cq-full) ring_enter with 4 free CQ slots
+(ring-cq-full) stopped when CQ full
+(ring-cq-full) ring_enter with full CQ
+(ring-cq-full) ring_enter after consuming results
+(ring-cq-full) all calls completed
+(ring-cq-full) end
+ring-cq-full: exit(0)
+EOF
+pass;
@@ -0,0 +1,49 @@
+/* Submits calls that may not run from a ring, and a call number
+   that does not exist, followed by one that may.  Each of the
+   former must complete with -1 without running; the last must
+   run normally. */
+
+#include <syscall.h>
+#include <syscall-nr.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct ring ring;
+
+/* Queues a call to NUMBER with argument ARG0 on RING. */
+static void
+submit (int number, int arg0) 
+{
+  struct ring_sqe *sqe = &ring.sq[ring.sq_tail % RING_ENTRIES];
+
+  sqe->number = number;
+  sqe->args[0] = arg0;
+  sqe->user_data = ring.sq_tail++;
+}
+
+void
+test_main (void) 
+{
+  int handle;
+  uint32_t i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  submit (SYS_HALT, 0);
+  submit (SYS_EXIT, 57);
+  submit (SYS_EXEC, 0);
+  submit (SYS_WAIT, 0);
+  submit (SYS_RING_ENTER, (int) &ring);
+  submit (-1, 0);
+  submit (1000, 0);
+  submit (SYS_FILESIZE, handle);
+
+  CHECK (ring_enter (&ring) == 8, "ring_enter");
+  CHECK (ring.sq_head == 8 && ring.cq_tail == 8, "all calls completed");
+  for (i = 0; i < 7; i++)
+    if (ring.cq[i].result != -1 || ring.cq[i].user_data != i)
+      fail ("completion %u: result %d, user data %u",
+            i, ring.cq[i].result, ring.cq[i].user_data);
+  CHECK (ring.cq[7].result == filesize (handle) && ring.cq[7].user_data == 7,
+         "filesize completed");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-not-batchable) begin
+(ring-not-batchable) open "sample.txt"
+(ring-not-batchable) ring_enter
+(ring-not-batchable) all calls completed
+(ring-not-batchable) filesize completed
+(ring-not-batchable) end
+ring-not-batchable: exit(0)
+EOF
+pass;
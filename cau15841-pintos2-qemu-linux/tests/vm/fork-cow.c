@@ -0,0 +1,35 @@
+/* Forks a child and checks that a write to a page that the two
+   processes share copy-on-write, by either of them after the
+   fork, is seen only by the process that made it. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int value;
+
+void
+test_main (void)
+{
+  pid_t child;
+
+  value = 1;
+  child = fork ();
+  if (child == 0)
+    {
+      /* Wait for the parent to write VALUE first. */
+      while (open ("written") < 0)
+        continue;
+      msg ("child sees %d", value);
+      value = 2;
+      msg ("child wrote %d", value);
+      exit (81);
+    }
+  CHECK (child > 0, "fork");
+  value = 3;
+  CHECK (create ("written", 0), "create \"written\"");
+  quiet = true;
+  CHECK (wait (child) == 81, "wait for child");
+  quiet = false;
+  msg ("parent sees %d", value);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-cow) begin
+(fork-cow) fork
+(fork-cow) create "written"
+(fork-cow) child sees 1
+(fork-cow) child wrote 2
+fork-cow: exit(81)
+(fork-cow) parent sees 3
+(fork-cow) end
+fork-cow: exit(0)
+EOF
+pass;
@@ -0,0 +1,45 @@
+/* Maps a file into memory and forks.  The child, which keeps
+   the mapping, checks that it sees the file's data and writes
+   to it, and the parent checks that it sees the write, because
+   both processes share the pages of a mapped file. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+
+static const char forked[] = "written by the child";
+
+void
+test_main (void)
+{
+  int handle;
+  pid_t child;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (mmap (handle, ACTUAL) != MAP_FAILED, "mmap \"sample.txt\"");
+
+  child = fork ();
+  if (child == 0)
+    {
+      if (memcmp (ACTUAL, sample, strlen (sample)))
+        fail ("child read bad data from mapping");
+      msg ("child writes to mapping");
+      memcpy (ACTUAL, forked, sizeof forked);
+      exit (83);
+    }
+  if (child < 0)
+    fail ("fork failed");
+  quiet = true;
+  CHECK (wait (child) == 83, "wait for child");
+  quiet = false;
+
+  CHECK (!memcmp (ACTUAL, forked, sizeof forked),
+         "parent sees child's write");
+  CHECK (!memcmp (ACTUAL + sizeof forked, sample + sizeof forked,
+                  strlen (sample) - sizeof forked),
+         "rest of mapping unchanged");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-mmap) begin
+(fork-mmap) open "sample.txt"
+(fork-mmap) mmap "sample.txt"
+(fork-mmap) child writes to mapping
+fork-mmap: exit(83)
+(fork-mmap) parent sees child's write
+(fork-mmap) rest of mapping unchanged
+(fork-mmap) end
+fork-mmap: exit(0)
+EOF
+pass;
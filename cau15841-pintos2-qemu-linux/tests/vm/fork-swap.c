@@ -0,0 +1,59 @@
+/* Fills 2 MB of memory, which pushes its first pages out to
+   swap, then forks.  The child, which shares those pages with
+   the parent through their swap slots, checks their contents
+   and overwrites one.  The parent then checks that its copy is
+   unchanged. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define SIZE (2 * 1024 * 1024)
+
+static char buf[SIZE];
+
+/* Checks that every page of BUF still holds its own page
+   number. */
+static void
+check_pages (void)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != (char) (i / PAGE_SIZE))
+      fail ("byte %zu is %d, not %d", i, buf[i], (char) (i / PAGE_SIZE));
+}
+
+void
+test_main (void)
+{
+  pid_t child;
+  size_t i;
+
+  msg ("fill pages");
+  for (i = 0; i < SIZE; i += PAGE_SIZE)
+    memset (buf + i, i / PAGE_SIZE, PAGE_SIZE);
+
+  child = fork ();
+  if (child == 0)
+    {
+      msg ("child checks pages");
+      check_pages ();
+      msg ("child overwrites first page");
+      memset (buf, 0xcc, PAGE_SIZE);
+      for (i = 0; i < PAGE_SIZE; i++)
+        if (buf[i] != (char) 0xcc)
+          fail ("child's byte %zu is %d, not %d", i, buf[i], (char) 0xcc);
+      exit (82);
+    }
+  if (child < 0)
+    fail ("fork failed");
+  quiet = true;
+  CHECK (wait (child) == 82, "wait for child");
+  quiet = false;
+
+  msg ("parent checks pages");
+  check_pages ();
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-swap) begin
+(fork-swap) fill pages
+(fork-swap) child checks pages
+(fork-swap) child overwrites first page
+fork-swap: exit(82)
+(fork-swap) parent checks pages
+(fork-swap) end
+fork-swap: exit(0)
+EOF
+pass;
@@ -0,0 +1,63 @@
+/* Reads an all-zero page, which maps the shared zero frame, and
+   forks.  Each process then writes to that page and to one that
+   neither touched before the fork, and checks that it sees only
+   its own writes, and that a third page still reads as zeros. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+
+/* Three pages in the BSS, which start out as zero pages. */
+static char zeros[3][PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+/* Checks that page PAGE is all zeros, except that its first
+   byte is FIRST. */
+static void
+check_page (int page, char first)
+{
+  size_t i;
+
+  if (zeros[page][0] != first)
+    fail ("page %d starts with %d, not %d", page, zeros[page][0], first);
+  for (i = 1; i < PAGE_SIZE; i++)
+    if (zeros[page][i] != 0)
+      fail ("byte %zu of page %d is %d, not 0", i, page, zeros[page][i]);
+}
+
+/* Writes C to pages 0 and 1 and checks all three pages. */
+static void
+write_pages (const char *who, char c)
+{
+  msg ("%s writes", who);
+  zeros[0][0] = c;
+  zeros[1][0] = c;
+  check_page (0, c);
+  check_page (1, c);
+  check_page (2, 0);
+}
+
+void
+test_main (void)
+{
+  pid_t child;
+
+  check_page (0, 0);
+  child = fork ();
+  if (child == 0)
+    {
+      write_pages ("child", 'c');
+      exit (84);
+    }
+  if (child < 0)
+    fail ("fork failed");
+  quiet = true;
+  CHECK (wait (child) == 84, "wait for child");
+  quiet = false;
+
+  msg ("parent checks");
+  check_page (0, 0);
+  check_page (1, 0);
+  write_pages ("parent", 'p');
+}
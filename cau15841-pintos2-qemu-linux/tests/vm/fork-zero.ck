@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fork-zero) begin
+(fork-zero) child writes
+fork-zero: exit(84)
+(fork-zero) parent checks
+(fork-zero) parent writes
+(fork-zero) end
+fork-zero: exit(0)
+EOF
+pass;
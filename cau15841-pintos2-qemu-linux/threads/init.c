@@ -19,6 +19,7 @@
 #include "threads/io.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
+#include "threads/memtrack.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
 #include "threads/thread.h"
@@ -37,10 +38,25 @@
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
+#ifdef VM
+#include "vm/frame.h"
+#include "vm/page.h"
+#include "vm/pagecache.h"
+#include "vm/swap.h"
+#include "vm/wset.h"
+#endif
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
 
+/* Flags in control register 4. */
+#define CR4_PSE 0x00000010      /* Page Size Extensions (4 MB pages). */
+#define CR4_PGE 0x00000080      /* Page Global Enable. */
+
+/* Feature flags reported in EDX by CPUID leaf 1. */
+#define CPUID_PSE 0x00000008    /* Page Size Extensions. */
+#define CPUID_PGE 0x00002000    /* Page Global Enable. */
+
 #ifdef FILESYS
 /* -f: Format the file system? */
 static bool format_filesys;
@@ -59,6 +75,7 @@ static size_t user_page_limit = SIZE_MAX;
 
 static void bss_init (void);
 static void paging_init (void);
+static uint32_t cpuid_features (void);
 
 static char **read_command_line (void);
 static char **parse_options (char **argv);
@@ -97,6 +114,7 @@ main (void)
   /* Initialize memory system. */
   palloc_init (user_page_limit);
   malloc_init ();
+  memtrack_init ();
   paging_init ();
 
   /* Segmentation. */
@@ -127,6 +145,14 @@ main (void)
   filesys_init (format_filesys);
 #endif
 
+#ifdef VM
+  /* Initialize virtual memory. */
+  frame_init ();
+  swap_init ();
+  pagecache_init ();
+  wset_init ();
+#endif
+
   printf ("Boot complete.\n");
   
   /* Run actions specified on kernel command line. */
@@ -153,13 +179,29 @@ bss_init (void)
 /* Populates the base page directory and page table with the
    kernel virtual mapping, and then sets up the CPU to use the
    new page directory.  Points init_page_dir to the page
-   directory it creates. */
+   directory it creates.
+
+   If the CPU supports 4 MB pages, each 4 MB region that lies
+   entirely within RAM and holds no kernel text is mapped by a
+   single large-page PDE instead of a page table, which saves the
+   page tables and a great many TLB entries.  The region holding
+   the kernel text still uses 4 kB pages so that the text stays
+   read-only.
+
+   The kernel mapping is identical in every page directory, so if
+   the CPU supports it, its pages are also marked global.  Their
+   TLB entries then survive the CR3 loads done at process
+   switches. */
 static void
 paging_init (void)
 {
   uint32_t *pd, *pt;
   size_t page;
   extern char _start, _end_kernel_text;
+  uint32_t features = cpuid_features ();
+  bool pse = (features & CPUID_PSE) != 0;
+  bool pge = (features & CPUID_PGE) != 0;
+  uint32_t global = pge ? PTE_G : 0;
 
   pd = init_page_dir = palloc_get_page (PAL_ASSERT | PAL_ZERO);
   pt = NULL;
@@ -171,13 +213,31 @@ paging_init (void)
       size_t pte_idx = pt_no (vaddr);
       bool in_kernel_text = &_start <= vaddr && vaddr < &_end_kernel_text;
 
+      if (pse && pte_idx == 0
+          && page + (PTSPAN / PGSIZE) <= init_ram_pages
+          && (vaddr + PTSPAN <= &_start || vaddr >= &_end_kernel_text))
+        {
+          pd[pde_idx] = pde_create_large (vaddr) | global;
+          page += PTSPAN / PGSIZE - 1;
+          continue;
+        }
+
       if (pd[pde_idx] == 0)
         {
           pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
           pd[pde_idx] = pde_create (pt);
         }
 
-      pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text);
+      pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text) | global;
+    }
+
+  /* Large-page PDEs are only honored once CR4.PSE is set.  See
+     [IA32-v3a] 3.6.1 "Paging Options". */
+  if (pse)
+    {
+      uint32_t cr4;
+      asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+      asm volatile ("movl %0, %%cr4" : : "r" (cr4 | CR4_PSE));
     }
 
   /* Store the physical address of the page directory into CR3
@@ -186,6 +246,27 @@ paging_init (void)
      to/from Control Registers" and [IA32-v3a] 3.7.5 "Base Address
      of the Page Directory". */
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (init_page_dir)));
+
+  /* Enable global pages only now that the new page directory is
+     active, so that no stale translation from the boot page
+     tables in start.S can become global.  See [IA32-v3a] 3.12
+     "Translation Lookaside Buffers (TLBs)". */
+  if (pge)
+    {
+      uint32_t cr4;
+      asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+      asm volatile ("movl %0, %%cr4" : : "r" (cr4 | CR4_PGE));
+    }
+}
+
+/* Returns the feature flags that CPUID leaf 1 reports in EDX.
+   See [IA32-v2a] "CPUID--CPU Identification". */
+static uint32_t
+cpuid_features (void) 
+{
+  uint32_t eax, ebx, ecx, edx;
+  asm ("cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx) : "a" (1));
+  return edx;
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -250,12 +331,18 @@ parse_options (char **argv)
 #ifdef VM
       else if (!strcmp (name, "-swap"))
         swap_bdev_name = value;
+      else if (!strcmp (name, "-stack"))
+        stack_page_limit = atoi (value);
+      else if (!strcmp (name, "-wset"))
+        wset_period_ms = atoi (value);
 #endif
 #endif
       else if (!strcmp (name, "-rs"))
         random_init (atoi (value));
       else if (!strcmp (name, "-mlfqs"))
         thread_mlfqs = true;
+      else if (!strcmp (name, "-memtrack"))
+        memtrack_enabled = true;
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
@@ -375,10 +462,13 @@ usage (void)
           "  -scratch=BDEV      Use BDEV for scratch instead of default.\n"
 #ifdef VM
           "  -swap=BDEV         Use BDEV for swap instead of default.\n"
+          "  -stack=PAGES       Let user stacks grow to PAGES pages.\n"
+          "  -wset=MS           Sample working sets every MS ms (0=never).\n"
 #endif
 #endif
           "  -rs=SEED           Set random number seed to SEED.\n"
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
+          "  -memtrack          Report kernel allocations by call site.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -5,9 +5,15 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
+#include "threads/memtrack.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef USERPROG
+#include "userprog/memacct.h"
+#endif
 
 /* A simple implementation of malloc().
 
@@ -32,13 +38,31 @@
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
    with the page allocator and sticking the allocation size at
-   the beginning of the allocated block's arena header. */
+   the beginning of the allocated block's arena header.
+
+   The descriptor for a request is found in constant time through
+   the size_to_desc[] table, which maps a size, in 16-byte
+   granules, to the index of the smallest descriptor that fits.
+
+   Each thread also keeps a small "magazine" of free blocks per
+   descriptor (see struct malloc_magazine in malloc.h).  malloc()
+   pops from and free() pushes onto the running thread's
+   magazine, which needs no locking because no other thread ever
+   touches it.  Only when a magazine runs empty or overflows do
+   we take the descriptor's lock, and then we move half a
+   magazine's worth of blocks at a time.  A magazine holds about
+   MAG_BYTES bytes of blocks per descriptor, so it holds many
+   small blocks but only a couple of big ones.  Blocks sitting in
+   a magazine still count as in use as far as their arena is
+   concerned. */
 
 /* Descriptor. */
 struct desc
   {
     size_t block_size;          /* Size of each element in bytes. */
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
+    size_t mag_capacity;        /* Max blocks in a thread's magazine. */
+    size_t mag_batch;           /* Blocks moved per refill or drain. */
     struct list free_list;      /* List of free blocks. */
     struct lock lock;           /* Lock. */
   };
@@ -58,20 +82,36 @@ struct arena
 struct block 
   {
     struct list_elem free_elem; /* Free list element. */
+    struct block *mag_next;     /* Next block in a thread's magazine. */
   };
 
 /* Our set of descriptors. */
-static struct desc descs[10];   /* Descriptors. */
+static struct desc descs[MALLOC_CLASS_CNT]; /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Size-to-descriptor lookup table. */
+#define GRANULE_SHIFT 4                 /* log2 of smallest block size. */
+#define MAX_BLOCK_SIZE (PGSIZE / 4)     /* Largest small block size. */
+static uint8_t size_to_desc[MAX_BLOCK_SIZE >> GRANULE_SHIFT];
+
+/* Bytes of free blocks a magazine holds for each descriptor.
+   Every magazine holds at least 2 blocks. */
+#define MAG_BYTES 1024
+
 static struct arena *block_to_arena (struct block *);
+static void charge (tid_t owner, int bytes);
+static void *alloc_block (size_t, const void *caller);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static bool magazine_refill (struct malloc_magazine *, size_t desc_idx);
+static void magazine_drain (struct malloc_magazine *, size_t desc_idx,
+                            size_t cnt);
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) 
 {
   size_t block_size;
+  size_t i;
 
   for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2)
     {
@@ -79,9 +119,25 @@ malloc_init (void)
       ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
       d->block_size = block_size;
       d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
+      d->mag_capacity = (block_size < MAG_BYTES / 2
+                         ? MAG_BYTES / block_size : 2);
+      d->mag_batch = d->mag_capacity / 2;
+      ASSERT (d->mag_capacity <= UINT8_MAX);
       list_init (&d->free_list);
       lock_init (&d->lock);
     }
+  ASSERT (desc_cnt == MALLOC_CLASS_CNT);
+  ASSERT (descs[desc_cnt - 1].block_size == MAX_BLOCK_SIZE);
+
+  /* Granule I holds sizes (I * 16, (I + 1) * 16]. */
+  for (i = 0; i < sizeof size_to_desc; i++)
+    {
+      size_t size = (i + 1) << GRANULE_SHIFT;
+      size_t d = 0;
+      while (descs[d].block_size < size)
+        d++;
+      size_to_desc[i] = d;
+    }
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -89,25 +145,33 @@ malloc_init (void)
 void *
 malloc (size_t size) 
 {
-  struct desc *d;
+  return alloc_block (size, __builtin_return_address (0));
+}
+
+/* Obtains and returns a new block of at least SIZE bytes, for
+   malloc(), and reports it to the allocation tracker as
+   allocated by CALLER: as heap if it comes from a descriptor,
+   otherwise as the pages that hold it.  Returns a null pointer
+   if memory is not available. */
+static void *
+alloc_block (size_t size, const void *caller)
+{
+  struct malloc_magazine *mag;
   struct block *b;
   struct arena *a;
+  tid_t owner = TID_ERROR;
+  size_t d;
 
   /* A null pointer satisfies a request for 0 bytes. */
   if (size == 0)
     return NULL;
 
-  /* Find the smallest descriptor that satisfies a SIZE-byte
-     request. */
-  for (d = descs; d < descs + desc_cnt; d++)
-    if (d->block_size >= size)
-      break;
-  if (d == descs + desc_cnt) 
+  if (size > MAX_BLOCK_SIZE) 
     {
       /* SIZE is too big for any descriptor.
          Allocate enough pages to hold SIZE plus an arena. */
       size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
-      a = palloc_get_multiple (0, page_cnt);
+      a = palloc_get_multiple_for (0, page_cnt, caller);
       if (a == NULL)
         return NULL;
 
@@ -119,37 +183,22 @@ malloc (size_t size)
       return a + 1;
     }
 
-  lock_acquire (&d->lock);
-
-  /* If the free list is empty, create a new arena. */
-  if (list_empty (&d->free_list))
-    {
-      size_t i;
-
-      /* Allocate a page. */
-      a = palloc_get_page (0);
-      if (a == NULL) 
-        {
-          lock_release (&d->lock);
-          return NULL; 
-        }
-
-      /* Initialize arena and add its blocks to the free list. */
-      a->magic = ARENA_MAGIC;
-      a->desc = d;
-      a->free_cnt = d->blocks_per_arena;
-      for (i = 0; i < d->blocks_per_arena; i++) 
-        {
-          struct block *b = arena_to_block (a, i);
-          list_push_back (&d->free_list, &b->free_elem);
-        }
-    }
+  /* Find the smallest descriptor that satisfies a SIZE-byte
+     request, and take a block from our magazine for it. */
+  ASSERT (!intr_context ());
+  d = size_to_desc[(size - 1) >> GRANULE_SHIFT];
+  mag = &thread_current ()->magazine;
+  if (mag->cnt[d] == 0 && !magazine_refill (mag, d))
+    return NULL;
 
-  /* Get a block from free list and return it. */
-  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-  a = block_to_arena (b);
-  a->free_cnt--;
-  lock_release (&d->lock);
+  b = mag->top[d];
+  mag->top[d] = b->mag_next;
+  mag->cnt[d]--;
+#ifdef USERPROG
+  owner = thread_current ()->tid;
+#endif
+  if (memtrack_alloc (MEMTRACK_HEAP, caller, b, descs[d].block_size, owner))
+    charge (owner, descs[d].block_size);
   return b;
 }
 
@@ -167,7 +216,7 @@ calloc (size_t a, size_t b)
     return NULL;
 
   /* Allocate and zero memory. */
-  p = malloc (size);
+  p = alloc_block (size, __builtin_return_address (0));
   if (p != NULL)
     memset (p, 0, size);
 
@@ -190,7 +239,12 @@ block_size (void *block)
    If successful, returns the new block; on failure, returns a
    null pointer.
    A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
-   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK).
+
+   The block is resized in place whenever possible: a normal
+   block stays put as long as NEW_SIZE fits its descriptor's
+   block size, and a big block gives back its trailing pages to
+   shrink or claims the pages that directly follow it to grow. */
 void *
 realloc (void *old_block, size_t new_size) 
 {
@@ -199,12 +253,40 @@ realloc (void *old_block, size_t new_size)
       free (old_block);
       return NULL;
     }
+  else if (old_block == NULL)
+    return alloc_block (new_size, __builtin_return_address (0));
   else 
     {
-      void *new_block = malloc (new_size);
-      if (old_block != NULL && new_block != NULL)
+      struct arena *a = block_to_arena (old_block);
+      size_t old_size = block_size (old_block);
+      void *new_block;
+
+      if (a->desc != NULL)
+        {
+          if (new_size <= old_size)
+            return old_block;
+        }
+      else if (new_size > MAX_BLOCK_SIZE)
+        {
+          size_t page_cnt = DIV_ROUND_UP (new_size + sizeof *a, PGSIZE);
+          if (page_cnt < a->free_cnt)
+            {
+              palloc_shrink (a, a->free_cnt, page_cnt);
+              a->free_cnt = page_cnt;
+              return old_block;
+            }
+          if (page_cnt == a->free_cnt
+              || palloc_extend (a, a->free_cnt, page_cnt - a->free_cnt))
+            {
+              a->free_cnt = page_cnt;
+              return old_block;
+            }
+        }
+
+      /* No room in place, so move the block. */
+      new_block = alloc_block (new_size, __builtin_return_address (0));
+      if (new_block != NULL)
         {
-          size_t old_size = block_size (old_block);
           size_t min_size = new_size < old_size ? new_size : old_size;
           memcpy (new_block, old_block, min_size);
           free (old_block);
@@ -223,36 +305,25 @@ free (void *p)
       struct block *b = p;
       struct arena *a = block_to_arena (b);
       struct desc *d = a->desc;
-      
+
       if (d != NULL) 
         {
-          /* It's a normal block.  We handle it here. */
-
+          /* It's a normal block.  Push it onto our magazine. */
+          struct malloc_magazine *mag = &thread_current ()->magazine;
+          size_t idx = d - descs;
+          tid_t owner = memtrack_free (p, d->block_size);
 #ifndef NDEBUG
           /* Clear the block to help detect use-after-free bugs. */
           memset (b, 0xcc, d->block_size);
 #endif
-  
-          lock_acquire (&d->lock);
 
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
-
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena) 
-            {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++) 
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
-            }
-
-          lock_release (&d->lock);
+          ASSERT (!intr_context ());
+          if (mag->cnt[idx] >= d->mag_capacity)
+            magazine_drain (mag, idx, d->mag_batch);
+          b->mag_next = mag->top[idx];
+          mag->top[idx] = b;
+          mag->cnt[idx]++;
+          charge (owner, -(int) d->block_size);
         }
       else
         {
@@ -262,7 +333,111 @@ free (void *p)
         }
     }
 }
-
+
+/* Returns every block cached in MAG to its descriptor.  Called
+   by a thread on its own magazine before it exits, so that the
+   blocks aren't lost along with the thread. */
+void
+malloc_magazine_flush (struct malloc_magazine *mag) 
+{
+  size_t i;
+
+  for (i = 0; i < desc_cnt; i++)
+    if (mag->cnt[i] > 0)
+      magazine_drain (mag, i, mag->cnt[i]);
+}
+
+/* Moves up to a batch of blocks from descriptor DESC_IDX's free
+   list into MAG, creating a new arena if the list is empty.
+   Returns true if at least one block was moved, false if memory
+   is not available. */
+static bool
+magazine_refill (struct malloc_magazine *mag, size_t desc_idx) 
+{
+  struct desc *d = &descs[desc_idx];
+  size_t moved;
+
+  lock_acquire (&d->lock);
+  for (moved = 0; moved < d->mag_batch; moved++) 
+    {
+      struct block *b;
+      struct arena *a;
+
+      /* If the free list is empty, create a new arena. */
+      if (list_empty (&d->free_list))
+        {
+          size_t i;
+
+          /* Allocate a page.  It is not charged to anyone as
+             kernel pages: its blocks are charged as heap as they
+             are handed out. */
+          a = palloc_get_page (PAL_UNCHARGED);
+          if (a == NULL) 
+            break;
+
+          /* Initialize arena and add its blocks to the free list. */
+          a->magic = ARENA_MAGIC;
+          a->desc = d;
+          a->free_cnt = d->blocks_per_arena;
+          for (i = 0; i < d->blocks_per_arena; i++) 
+            {
+              struct block *b = arena_to_block (a, i);
+              list_push_back (&d->free_list, &b->free_elem);
+            }
+        }
+
+      /* Move a block from the free list to the magazine. */
+      b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
+      a = block_to_arena (b);
+      a->free_cnt--;
+      b->mag_next = mag->top[desc_idx];
+      mag->top[desc_idx] = b;
+      mag->cnt[desc_idx]++;
+    }
+  lock_release (&d->lock);
+
+  return moved > 0;
+}
+
+/* Returns CNT blocks from the top of MAG's stack for descriptor
+   DESC_IDX to that descriptor's free list, giving any arena that
+   becomes entirely unused back to the page allocator. */
+static void
+magazine_drain (struct malloc_magazine *mag, size_t desc_idx, size_t cnt) 
+{
+  struct desc *d = &descs[desc_idx];
+
+  ASSERT (cnt <= mag->cnt[desc_idx]);
+
+  lock_acquire (&d->lock);
+  while (cnt-- > 0) 
+    {
+      struct block *b = mag->top[desc_idx];
+      struct arena *a = block_to_arena (b);
+
+      mag->top[desc_idx] = b->mag_next;
+      mag->cnt[desc_idx]--;
+
+      /* Add block to free list. */
+      list_push_front (&d->free_list, &b->free_elem);
+
+      /* If the arena is now entirely unused, free it. */
+      if (++a->free_cnt >= d->blocks_per_arena) 
+        {
+          size_t i;
+
+          ASSERT (a->free_cnt == d->blocks_per_arena);
+          for (i = 0; i < d->blocks_per_arena; i++) 
+            {
+              struct block *b = arena_to_block (a, i);
+              list_remove (&b->free_elem);
+            }
+          palloc_free_page (a);
+        }
+    }
+  lock_release (&d->lock);
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
@@ -292,3 +467,17 @@ arena_to_block (struct arena *a, size_t idx)
                            + sizeof *a
                            + idx * a->desc->block_size);
 }
+
+/* Charges thread OWNER for BYTES more bytes of heap, or credits
+   it if BYTES is negative.  Does nothing if OWNER is TID_ERROR.
+   Only blocks from descriptors are charged here: the page
+   allocator already charges a big block's pages as kernel
+   pages. */
+static void
+charge (tid_t owner UNUSED, int bytes UNUSED)
+{
+#ifdef USERPROG
+  if (owner != TID_ERROR)
+    memacct_heap_bytes (owner, bytes);
+#endif
+}
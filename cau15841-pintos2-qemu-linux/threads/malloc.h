@@ -3,11 +3,25 @@
 
 #include <debug.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/* Number of small-block size classes: 16, 32, ..., 1024 bytes. */
+#define MALLOC_CLASS_CNT 7
+
+/* Per-thread cache of free small blocks, one stack per size
+   class.  Lets the common malloc()/free() pair run without
+   touching a descriptor's free list or taking its lock. */
+struct malloc_magazine
+  {
+    void *top[MALLOC_CLASS_CNT];        /* Top block of each stack. */
+    uint8_t cnt[MALLOC_CLASS_CNT];       /* Blocks on each stack. */
+  };
 
 void malloc_init (void);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
 void *realloc (void *, size_t);
 void free (void *);
+void malloc_magazine_flush (struct malloc_magazine *);
 
 #endif /* threads/malloc.h */
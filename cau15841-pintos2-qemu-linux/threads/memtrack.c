@@ -0,0 +1,321 @@
+#include "threads/memtrack.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+/* Tracking of kernel allocations by call site and by owner.
+
+   malloc() and palloc_get_*() report every allocation here along
+   with their caller's address and the thread, if any, that the
+   memory is charged to, and the matching frees.  A malloc()
+   block too big for a size class is reported once, as the pages
+   that hold it, under malloc()'s caller.  Two side tables, both
+   open-addressed hash tables with linear probing, hold the data:
+
+   - SITES has one entry per call site, with its live and peak
+     bytes and its number of allocations.  It is kept only with
+     the -memtrack option.
+
+   - RECORDS has one 12-byte entry per live allocation, mapping
+     the block's address to its call site and its owner, so that
+     a free can be credited to the site and the thread that made
+     the allocation, whichever thread frees it.  Block sizes are
+     not stored: the allocators know them at free time.  Without
+     -memtrack, only allocations with an owner are recorded, and
+     only if there are owners at all, that is, with USERPROG.
+
+   Allocations made before memtrack_init(), or that do not fit in
+   the tables, are not tracked, and neither are their frees.  The
+   tables are only touched with interrupts off. */
+
+/* Number of call sites that can be tracked.  A power of 2. */
+#define SITE_CNT 512
+
+/* Pages of allocation records. */
+#define RECORD_PAGES 24
+
+/* SITE of a record whose call site is not tracked. */
+#define NO_SITE UINT16_MAX
+
+/* A call site. */
+struct site
+  {
+    const void *caller;         /* Return address, or null if unused. */
+    enum memtrack_kind kind;    /* Kind of allocation. */
+    uint32_t live_bytes;        /* Bytes allocated and not yet freed. */
+    uint32_t peak_bytes;        /* Highest LIVE_BYTES seen. */
+    uint32_t alloc_cnt;         /* Number of allocations. */
+  };
+
+/* A live allocation. */
+struct record
+  {
+    const void *block;          /* Allocated block, or null if unused. */
+    tid_t owner;                /* Thread charged, or TID_ERROR. */
+    uint16_t site;              /* Index in SITES, or NO_SITE. */
+  };
+
+bool memtrack_enabled;
+
+static struct site sites[SITE_CNT];
+static size_t site_cnt;
+
+static struct record *records;
+static size_t record_cap;       /* Number of entries, a power of 2. */
+static size_t record_cnt;       /* Number of entries in use. */
+
+/* Allocations that could not be tracked. */
+static uint32_t untracked_cnt;
+
+static unsigned hash_ptr (const void *);
+static struct site *lookup_site (const void *caller, enum memtrack_kind);
+static struct record *lookup_record (const void *block);
+static void remove_record (struct record *);
+
+/* Allocates the allocation record table and starts tracking.
+   Must be called after the page allocator is initialized. */
+void
+memtrack_init (void)
+{
+#ifndef USERPROG
+  if (!memtrack_enabled)
+    return;
+#endif
+  records = palloc_get_multiple (PAL_ASSERT | PAL_ZERO, RECORD_PAGES);
+  record_cap = RECORD_PAGES * PGSIZE / sizeof *records;
+  ASSERT ((record_cap & (record_cap - 1)) == 0);
+}
+
+/* Records that CALLER allocated BLOCK, which is SIZE bytes, with
+   an allocator of the given KIND, on behalf of thread OWNER, or
+   of no thread if OWNER is TID_ERROR.  Returns true if the
+   allocation was recorded, in which case its free will report
+   OWNER, false otherwise. */
+bool
+memtrack_alloc (enum memtrack_kind kind, const void *caller,
+                const void *block, size_t size, tid_t owner)
+{
+  enum intr_level old_level;
+  struct site *s = NULL;
+  struct record *r;
+  bool recorded = false;
+
+  if (records == NULL || block == NULL
+      || (!memtrack_enabled && owner == TID_ERROR))
+    return false;
+
+  old_level = intr_disable ();
+  if (memtrack_enabled)
+    s = lookup_site (caller, kind);
+  r = lookup_record (block);
+  ASSERT (r->block == NULL);
+
+  /* Keep the table at most 3/4 full, so probes stay short. */
+  if (record_cnt < record_cap / 4 * 3
+      && (s != NULL || owner != TID_ERROR))
+    {
+      r->block = block;
+      r->owner = owner;
+      r->site = s != NULL ? s - sites : NO_SITE;
+      record_cnt++;
+      recorded = true;
+    }
+  if (s != NULL && recorded)
+    {
+      s->live_bytes += size;
+      if (s->live_bytes > s->peak_bytes)
+        s->peak_bytes = s->live_bytes;
+      s->alloc_cnt++;
+    }
+  else if (memtrack_enabled)
+    untracked_cnt++;
+  intr_set_level (old_level);
+
+  return recorded;
+}
+
+/* Records that tracked block BLOCK grew by DELTA bytes, or
+   shrank if DELTA is negative, without moving.  Returns the
+   block's owner, or TID_ERROR if it has none or is not
+   tracked. */
+tid_t
+memtrack_resize (const void *block, int delta)
+{
+  enum intr_level old_level;
+  struct record *r;
+  tid_t owner = TID_ERROR;
+
+  if (records == NULL)
+    return TID_ERROR;
+
+  old_level = intr_disable ();
+  r = lookup_record (block);
+  if (r->block != NULL)
+    {
+      if (r->site != NO_SITE)
+        {
+          struct site *s = &sites[r->site];
+          s->live_bytes += delta;
+          if (s->live_bytes > s->peak_bytes)
+            s->peak_bytes = s->live_bytes;
+        }
+      owner = r->owner;
+    }
+  intr_set_level (old_level);
+
+  return owner;
+}
+
+/* Records that BLOCK, which is SIZE bytes, was freed.  Returns
+   the thread that it was charged to, or TID_ERROR if it has no
+   owner or was not tracked. */
+tid_t
+memtrack_free (const void *block, size_t size)
+{
+  enum intr_level old_level;
+  struct record *r;
+  tid_t owner = TID_ERROR;
+
+  if (records == NULL || block == NULL)
+    return TID_ERROR;
+
+  old_level = intr_disable ();
+  r = lookup_record (block);
+  if (r->block != NULL)
+    {
+      if (r->site != NO_SITE)
+        sites[r->site].live_bytes -= size;
+      owner = r->owner;
+      remove_record (r);
+    }
+  intr_set_level (old_level);
+
+  return owner;
+}
+
+/* Prints live, peak and allocation rate for each call site,
+   those with the most live bytes first. */
+void
+memtrack_print_stats (void)
+{
+  static uint16_t order[SITE_CNT];
+  int64_t ticks = timer_ticks ();
+  size_t i, j, n = 0;
+
+  if (records == NULL || !memtrack_enabled)
+    return;
+
+  for (i = 0; i < SITE_CNT; i++)
+    if (sites[i].caller != NULL)
+      {
+        /* Insertion sort by live bytes, descending. */
+        for (j = n++; j > 0 && (sites[order[j - 1]].live_bytes
+                                < sites[i].live_bytes); j--)
+          order[j] = order[j - 1];
+        order[j] = i;
+      }
+
+  printf ("Kernel allocations: %zu call sites, %zu live blocks, "
+          "%"PRIu32" untracked\n", site_cnt, record_cnt, untracked_cnt);
+  for (i = 0; i < n; i++)
+    {
+      const struct site *s = &sites[order[i]];
+      printf ("  %-5s %p: %8"PRIu32" bytes live, %8"PRIu32" peak, "
+              "%6"PRIu32" allocs, %5"PRId64"/s\n",
+              s->kind == MEMTRACK_HEAP ? "heap" : "pages", s->caller,
+              s->live_bytes, s->peak_bytes, s->alloc_cnt,
+              (int64_t) s->alloc_cnt * TIMER_FREQ / (ticks > 0 ? ticks : 1));
+    }
+  printf ("Translate call sites with \"backtrace kernel.o ADDRESS...\".\n");
+}
+
+/* Returns a hash value for pointer P whose low bits depend on
+   all of P's bits, because pages are aligned much more coarsely
+   than heap blocks. */
+static unsigned
+hash_ptr (const void *p)
+{
+  unsigned h = (uintptr_t) p >> 4;
+
+  h ^= h >> 16;
+  h *= 0x45d9f3b;
+  h ^= h >> 16;
+  return h;
+}
+
+/* Returns the entry for CALLER's allocations of the given KIND,
+   creating it if necessary, or a null pointer if SITES is
+   full. */
+static struct site *
+lookup_site (const void *caller, enum memtrack_kind kind)
+{
+  size_t i = hash_ptr (caller) & (SITE_CNT - 1);
+
+  for (;;)
+    {
+      struct site *s = &sites[i];
+      if (s->caller == caller && s->kind == kind)
+        return s;
+      if (s->caller == NULL)
+        {
+          if (site_cnt >= SITE_CNT / 4 * 3)
+            return NULL;
+          s->caller = caller;
+          s->kind = kind;
+          site_cnt++;
+          return s;
+        }
+      i = (i + 1) & (SITE_CNT - 1);
+    }
+}
+
+/* Returns the record for BLOCK, or the empty entry where it
+   belongs if BLOCK is not tracked. */
+static struct record *
+lookup_record (const void *block)
+{
+  size_t i = hash_ptr (block) & (record_cap - 1);
+
+  while (records[i].block != NULL && records[i].block != block)
+    i = (i + 1) & (record_cap - 1);
+  return &records[i];
+}
+
+/* Removes record R, moving later records of the same probe
+   sequence back into the gap, so that no tombstones are
+   needed. */
+static void
+remove_record (struct record *r)
+{
+  size_t mask = record_cap - 1;
+  size_t i = r - records;
+  size_t j = i;
+
+  for (;;)
+    {
+      size_t home;
+
+      records[i].block = NULL;
+      do
+        {
+          j = (j + 1) & mask;
+          if (records[j].block == NULL)
+            {
+              record_cnt--;
+              return;
+            }
+          home = hash_ptr (records[j].block) & mask;
+        }
+      /* Record J stays put if its home lies cyclically in
+         (I, J]; moving it to I would put it before its home. */
+      while (i <= j ? i < home && home <= j : i < home || home <= j);
+
+      records[i] = records[j];
+      i = j;
+    }
+}
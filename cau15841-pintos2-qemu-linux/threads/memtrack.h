@@ -0,0 +1,26 @@
+#ifndef THREADS_MEMTRACK_H
+#define THREADS_MEMTRACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "threads/thread.h"
+
+/* Kinds of tracked allocation. */
+enum memtrack_kind
+  {
+    MEMTRACK_HEAP,              /* malloc() and friends. */
+    MEMTRACK_PAGES              /* palloc_get_*(). */
+  };
+
+/* If true, kernel allocations are tracked by call site.
+   Controlled by kernel command-line option "-memtrack". */
+extern bool memtrack_enabled;
+
+void memtrack_init (void);
+bool memtrack_alloc (enum memtrack_kind, const void *caller,
+                     const void *block, size_t size, tid_t owner);
+tid_t memtrack_resize (const void *block, int delta);
+tid_t memtrack_free (const void *block, size_t size);
+void memtrack_print_stats (void);
+
+#endif /* threads/memtrack.h */
@@ -6,10 +6,17 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
+#include "threads/memtrack.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef USERPROG
+#include "userprog/memacct.h"
+#endif
 
 /* Page allocator.  Hands out memory in page-size (or
    page-multiple) chunks.  See malloc.h for an allocator that
@@ -23,7 +30,20 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool also keeps a small cache of free pages that the idle
+   thread has already zeroed (see palloc_idle_zero()), so that
+   single-page PAL_ZERO requests usually need no memset.
+
+   Every pool collects the statistics in struct palloc_stats
+   (lib/memstat.h).  palloc_print_stats() prints them at shutdown
+   and palloc_get_stats() samples them for the memstat system
+   call.  Counters are updated with interrupts off, since the
+   free and zeroed-cache paths don't take the pool lock. */
+
+/* Number of pre-zeroed pages each pool keeps ready. */
+#define ZERO_CACHE_SIZE 64
 
 /* A memory pool. */
 struct pool
@@ -31,6 +51,16 @@ struct pool
     struct lock lock;                   /* Mutual exclusion. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
     uint8_t *base;                      /* Base of pool. */
+    size_t nextfit_start;               /* Where NEXTFIT scans begin. */
+
+    /* Free pages known to be zeroed.  They stay marked in use in
+       USED_MAP so that ordinary scans pass over them.  Accessed
+       only with interrupts off. */
+    void *zeroed[ZERO_CACHE_SIZE];
+    size_t zeroed_cnt;
+
+    struct palloc_stats stats;          /* Running statistics. */
+    uint64_t lock_start;                /* When LOCK was last taken. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -38,11 +68,26 @@ static struct pool kernel_pool, user_pool;
 
 //NEXTfIT 시작 지점을 계석 업데이트하면서 해당 구역부터시작하게 한다.
 static enum polloc_policys policy = NEXTFIT;
-static size_t nextfitStart;
 
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
+static size_t scan_pool (struct pool *, size_t page_cnt);
+static void *take_zeroed (struct pool *);
+static void release_zeroed (struct pool *);
+static bool prezero_page (struct pool *);
+static void pool_lock (struct pool *);
+static bool pool_try_lock (struct pool *);
+static void pool_unlock (struct pool *);
+static void count_pages (struct pool *, bool alloc, size_t page_cnt);
+static void *get_pages (enum palloc_flags, size_t page_cnt);
+static void release_pages (void *pages, size_t page_cnt);
+static void *track (void *pages, enum palloc_flags, size_t page_cnt,
+                    const void *caller);
+static void charge_pages (tid_t owner, int page_cnt);
+static void print_pool_stats (const char *name, enum memstat_pool);
 static bool page_from_pool (const struct pool *, void *page);
+static struct pool *page_to_pool (void *page);
+static int compare_indexes (const void *, const void *);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -63,19 +108,6 @@ palloc_init (size_t user_page_limit)
   init_pool (&kernel_pool, free_start, kernel_pages, "kernel pool");
   init_pool (&user_pool, free_start + kernel_pages * PGSIZE,
              user_pages, "user pool");
-  //nextfit을 한다면 nextfitStart를 0으로 초기화한다.
-  switch (policy)
-  {
-     case FIRSTFIT:
-    /* code */
-    break;
-     case NEXTFIT:
-     nextfitStart =0;
-    break;
-  
-  default:
-    break;
-  }
 }
 
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
@@ -86,51 +118,69 @@ palloc_init (size_t user_page_limit)
    FLAGS, in which case the kernel panics. */
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
+{
+  return track (get_pages (flags, page_cnt), flags, page_cnt,
+                __builtin_return_address (0));
+}
+
+/* Like palloc_get_multiple(), but reports the pages to the
+   allocation tracker as allocated by CALLER, for allocators
+   built on top of this one, such as malloc(). */
+void *
+palloc_get_multiple_for (enum palloc_flags flags, size_t page_cnt,
+                         const void *caller)
+{
+  return track (get_pages (flags, page_cnt), flags, page_cnt, caller);
+}
+
+/* Obtains and returns a group of PAGE_CNT contiguous free pages
+   for palloc_get_multiple(), without tracking them. */
+static void *
+get_pages (enum palloc_flags flags, size_t page_cnt)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-  void *pages;
+  void *pages = NULL;
   size_t page_idx;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  switch (policy)
-  {
-    case FIRSTFIT:
-      page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-      break;
-    case NEXTFIT:
-      page_idx = bitmap_scan_and_flip (pool->used_map, nextfitStart, page_cnt, false);
-      //만약 btmap 에러가 뜬다면, nextfitStart를 0으로 초기화하고, 다시 해본다.
-      if(page_idx == BITMAP_ERROR){
-        nextfitStart = 0;
-        page_idx = bitmap_scan_and_flip (pool->used_map, nextfitStart, page_cnt, false);
-      }
-      //page idx가 나온다면, 해당 page가 할당 된후 다음 주소를 nextfitStart에 넣어준다.
-      nextfitStart =  pool->base + PGSIZE * (page_idx + page_cnt);
-      break;
-    default:
-      break;
-  }
-  lock_release (&pool->lock);
+  /* A single zeroed page can usually come straight from the
+     pre-zeroed cache. */
+  if (page_cnt == 1 && (flags & PAL_ZERO))
+    pages = take_zeroed (pool);
 
-  if (page_idx != BITMAP_ERROR)
-    pages = pool->base + PGSIZE * page_idx;
-  else
-    pages = NULL;
-
-  if (pages != NULL) 
+  if (pages != NULL)
     {
-      if (flags & PAL_ZERO)
-        memset (pages, 0, PGSIZE * page_cnt);
+      enum intr_level old_level = intr_disable ();
+      pool->stats.zero_hit_cnt++;
+      intr_set_level (old_level);
     }
-  else 
+  else
     {
-      if (flags & PAL_ASSERT)
-        PANIC ("palloc_get: out of pages");
+      pool_lock (pool);
+      page_idx = scan_pool (pool, page_cnt);
+      if (page_idx == BITMAP_ERROR && pool->zeroed_cnt > 0)
+        {
+          /* Some free pages may be sitting in the zeroed cache.
+             Put them back and look again. */
+          release_zeroed (pool);
+          page_idx = scan_pool (pool, page_cnt);
+        }
+      pool_unlock (pool);
+
+      if (page_idx != BITMAP_ERROR)
+        {
+          pages = pool->base + PGSIZE * page_idx;
+          if (flags & PAL_ZERO)
+            memset (pages, 0, PGSIZE * page_cnt);
+        }
     }
 
+  count_pages (pool, true, pages != NULL ? page_cnt : 0);
+  if (pages == NULL && (flags & PAL_ASSERT))
+    PANIC ("palloc_get: out of pages");
+
   return pages;
 }
 
@@ -144,35 +194,174 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 void *
 palloc_get_page (enum palloc_flags flags) 
 {
-  return palloc_get_multiple (flags, 1);
+  return track (get_pages (flags, 1), flags, 1,
+                __builtin_return_address (0));
 }
 
 /* Frees the PAGE_CNT pages starting at PAGES. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) 
 {
-  struct pool *pool;
-  size_t page_idx;
+  tid_t owner;
 
   ASSERT (pg_ofs (pages) == 0);
   if (pages == NULL || page_cnt == 0)
     return;
 
-  if (page_from_pool (&kernel_pool, pages))
+  owner = memtrack_free (pages, PGSIZE * page_cnt);
+  release_pages (pages, page_cnt);
+  charge_pages (owner, -(int) page_cnt);
+}
+
+/* Shrinks the PAGE_CNT pages starting at PAGES, which must have
+   been obtained from the page allocator, to their first NEW_CNT
+   pages, and frees the rest.  NEW_CNT must not be 0. */
+void
+palloc_shrink (void *pages, size_t page_cnt, size_t new_cnt) 
+{
+  size_t free_cnt = page_cnt - new_cnt;
+  tid_t owner;
+
+  ASSERT (pg_ofs (pages) == 0);
+  ASSERT (new_cnt > 0 && new_cnt <= page_cnt);
+  if (free_cnt == 0)
+    return;
+
+  release_pages ((uint8_t *) pages + PGSIZE * new_cnt, free_cnt);
+  owner = memtrack_resize (pages, -(int) (PGSIZE * free_cnt));
+  charge_pages (owner, -(int) free_cnt);
+}
+
+/* Tries to grow the PAGE_CNT pages starting at PAGES, which
+   must have been obtained from the page allocator, by EXTRA_CNT
+   pages without moving them.  Succeeds only if the EXTRA_CNT
+   pages that directly follow are free and in the same pool, in
+   which case they are marked in use and true is returned.  The
+   contents of the new pages are undefined. */
+bool
+palloc_extend (void *pages, size_t page_cnt, size_t extra_cnt) 
+{
+  struct pool *pool;
+  size_t end_idx;
+  bool success = false;
+
+  ASSERT (pg_ofs (pages) == 0);
+  if (extra_cnt == 0)
+    return true;
+
+  pool = page_to_pool (pages);
+  end_idx = pg_no (pages) - pg_no (pool->base) + page_cnt;
+
+  pool_lock (pool);
+  if (end_idx + extra_cnt <= bitmap_size (pool->used_map))
+    {
+      if (!bitmap_none (pool->used_map, end_idx, extra_cnt)
+          && pool->zeroed_cnt > 0)
+        {
+          /* Some of the following pages may be sitting in the
+             zeroed cache.  Put them back and look again. */
+          release_zeroed (pool);
+        }
+      if (bitmap_none (pool->used_map, end_idx, extra_cnt))
+        {
+          bitmap_set_multiple (pool->used_map, end_idx, extra_cnt, true);
+          success = true;
+        }
+    }
+  pool_unlock (pool);
+  count_pages (pool, true, success ? extra_cnt : 0);
+  if (success)
+    charge_pages (memtrack_resize (pages, PGSIZE * extra_cnt), extra_cnt);
+
+  return success;
+}
+
+/* Zeroes one free page, if any pool's zeroed cache has room,
+   and adds it to the cache.  Called by the idle thread, with
+   interrupts on, whenever there is nothing else to run.  Never
+   blocks.  Returns true if a page was zeroed, false if there was
+   nothing to do. */
+bool
+palloc_idle_zero (void) 
+{
+  return prezero_page (&kernel_pool) || prezero_page (&user_pool);
+}
+
+/* Copies a sample of the statistics for POOL into *STATS.
+   Returns false if POOL is not a valid pool. */
+bool
+palloc_get_stats (enum memstat_pool pool_id, struct palloc_stats *stats) 
+{
+  struct pool *pool;
+  enum intr_level old_level;
+  size_t cached[ZERO_CACHE_SIZE];
+  size_t cached_cnt, next;
+  bool locked;
+  size_t run, i;
+
+  if (pool_id == MEMSTAT_KERNEL)
     pool = &kernel_pool;
-  else if (page_from_pool (&user_pool, pages))
+  else if (pool_id == MEMSTAT_USER)
     pool = &user_pool;
   else
-    NOT_REACHED ();
+    return false;
 
-  page_idx = pg_no (pages) - pg_no (pool->base);
+  /* Copy the counters with interrupts off, which is quick. */
+  old_level = intr_disable ();
+  *stats = pool->stats;
+  stats->zeroed_cnt = pool->zeroed_cnt;
+  intr_set_level (old_level);
+  stats->page_cnt = bitmap_size (pool->used_map);
+  stats->policy = policy;
 
-#ifndef NDEBUG
-  memset (pages, 0xcc, PGSIZE * page_cnt);
-#endif
+  /* Scan for the largest free run under the pool lock, as an
+     allocation does, so that interrupts stay on however large
+     the pool is.  The shutdown path after a kernel panic runs
+     with interrupts off and cannot block, but nothing else runs
+     then either, so it scans without the lock if it cannot take
+     it at once. */
+  if (intr_get_level () == INTR_ON)
+    {
+      pool_lock (pool);
+      locked = true;
+    }
+  else
+    locked = (!lock_held_by_current_thread (&pool->lock)
+              && pool_try_lock (pool));
 
-  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  /* Pages in the zeroed cache are free, even though they are
+     marked in use.  Take a sorted list of their indexes, so that
+     the scan can count them as free as it passes them. */
+  old_level = intr_disable ();
+  cached_cnt = pool->zeroed_cnt;
+  for (i = 0; i < cached_cnt; i++)
+    cached[i] = pg_no (pool->zeroed[i]) - pg_no (pool->base);
+  intr_set_level (old_level);
+  qsort (cached, cached_cnt, sizeof *cached, compare_indexes);
+
+  stats->largest_free_run = run = next = 0;
+  for (i = 0; i < stats->page_cnt; i++)
+    {
+      bool is_cached = next < cached_cnt && cached[next] == i;
+      if (is_cached)
+        next++;
+      if (bitmap_test (pool->used_map, i) && !is_cached)
+        run = 0;
+      else if (++run > stats->largest_free_run)
+        stats->largest_free_run = run;
+    }
+  if (locked)
+    pool_unlock (pool);
+
+  return true;
+}
+
+/* Prints page allocator statistics. */
+void
+palloc_print_stats (void) 
+{
+  print_pool_stats ("kernel", MEMSTAT_KERNEL);
+  print_pool_stats ("user", MEMSTAT_USER);
 }
 
 /* Frees the page at PAGE. */
@@ -201,6 +390,109 @@ init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
   lock_init (&p->lock);
   p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
   p->base = base + bm_pages * PGSIZE;
+  p->nextfit_start = 0;
+  p->zeroed_cnt = 0;
+}
+
+/* Finds PAGE_CNT contiguous free pages in POOL according to the
+   allocation policy, marks them in use, and returns the index of
+   the first one, or BITMAP_ERROR if there is no such run.
+   POOL's lock must be held. */
+static size_t
+scan_pool (struct pool *pool, size_t page_cnt) 
+{
+  struct palloc_policy_stats *pstats;
+  size_t page_idx;
+
+  ASSERT (lock_held_by_current_thread (&pool->lock));
+
+  pstats = &pool->stats.policies[policy];
+  pstats->scan_cnt++;
+  switch (policy)
+    {
+    case FIRSTFIT:
+      page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+      break;
+    case NEXTFIT:
+      page_idx = bitmap_scan_and_flip (pool->used_map, pool->nextfit_start,
+                                       page_cnt, false);
+      //만약 btmap 에러가 뜬다면, 처음부터 다시 해본다.
+      if (page_idx == BITMAP_ERROR && pool->nextfit_start != 0)
+        {
+          pstats->wrap_cnt++;
+          page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
+        }
+      //page idx가 나온다면, 할당된 구역 바로 다음 인덱스를 nextfit_start에 넣어준다.
+      if (page_idx != BITMAP_ERROR)
+        pool->nextfit_start = page_idx + page_cnt;
+      break;
+    default:
+      NOT_REACHED ();
+    }
+  if (page_idx == BITMAP_ERROR)
+    pstats->fail_cnt++;
+  return page_idx;
+}
+
+/* Removes and returns a page from POOL's zeroed cache, or a null
+   pointer if the cache is empty. */
+static void *
+take_zeroed (struct pool *pool) 
+{
+  enum intr_level old_level;
+  void *page = NULL;
+
+  old_level = intr_disable ();
+  if (pool->zeroed_cnt > 0)
+    page = pool->zeroed[--pool->zeroed_cnt];
+  intr_set_level (old_level);
+
+  return page;
+}
+
+/* Returns every page in POOL's zeroed cache to the free pages.
+   POOL's lock must be held. */
+static void
+release_zeroed (struct pool *pool) 
+{
+  void *page;
+
+  ASSERT (lock_held_by_current_thread (&pool->lock));
+
+  while ((page = take_zeroed (pool)) != NULL)
+    bitmap_reset (pool->used_map, pg_no (page) - pg_no (pool->base));
+}
+
+/* Takes one free page from POOL, zeroes it, and adds it to
+   POOL's zeroed cache.  Returns false without doing anything if
+   the cache is full, POOL's lock is busy, or POOL has no free
+   pages. */
+static bool
+prezero_page (struct pool *pool) 
+{
+  enum intr_level old_level;
+  size_t page_idx;
+  void *page;
+
+  /* Only this function adds to the cache, and only the idle
+     thread calls it, so the cache cannot fill up behind our
+     back. */
+  if (pool->zeroed_cnt >= ZERO_CACHE_SIZE || !pool_try_lock (pool))
+    return false;
+  page_idx = bitmap_scan_and_flip (pool->used_map, 0, 1, false);
+  pool_unlock (pool);
+  if (page_idx == BITMAP_ERROR)
+    return false;
+
+  page = pool->base + PGSIZE * page_idx;
+  memset (page, 0, PGSIZE);
+
+  old_level = intr_disable ();
+  ASSERT (pool->zeroed_cnt < ZERO_CACHE_SIZE);
+  pool->zeroed[pool->zeroed_cnt++] = page;
+  intr_set_level (old_level);
+
+  return true;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -214,3 +506,175 @@ page_from_pool (const struct pool *pool, void *page)
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* qsort() comparison function for page indexes. */
+static int
+compare_indexes (const void *a_, const void *b_) 
+{
+  const size_t *a = a_;
+  const size_t *b = b_;
+
+  return *a < *b ? -1 : *a > *b;
+}
+
+/* Returns the pool that PAGE was allocated from. */
+static struct pool *
+page_to_pool (void *page) 
+{
+  if (page_from_pool (&kernel_pool, page))
+    return &kernel_pool;
+  else if (page_from_pool (&user_pool, page))
+    return &user_pool;
+  else
+    NOT_REACHED ();
+}
+
+/* Returns the CPU's time-stamp counter. */
+static inline uint64_t
+rdtsc (void) 
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/* Acquires POOL's lock and starts timing how long it is held. */
+static void
+pool_lock (struct pool *pool) 
+{
+  lock_acquire (&pool->lock);
+  pool->lock_start = rdtsc ();
+}
+
+/* Tries to acquire POOL's lock without blocking.  Returns true
+   if successful, in which case the hold time is timed. */
+static bool
+pool_try_lock (struct pool *pool) 
+{
+  if (!lock_try_acquire (&pool->lock))
+    return false;
+  pool->lock_start = rdtsc ();
+  return true;
+}
+
+/* Releases POOL's lock and charges the time it was held. */
+static void
+pool_unlock (struct pool *pool) 
+{
+  enum intr_level old_level = intr_disable ();
+  pool->stats.lock_cnt++;
+  pool->stats.lock_cycles += rdtsc () - pool->lock_start;
+  intr_set_level (old_level);
+  lock_release (&pool->lock);
+}
+
+/* Records that PAGE_CNT pages were allocated from POOL (if ALLOC
+   is true) or freed to it (if ALLOC is false).  An allocation
+   with zero PAGE_CNT is counted as a failure. */
+static void
+count_pages (struct pool *pool, bool alloc, size_t page_cnt) 
+{
+  struct palloc_stats *stats = &pool->stats;
+  enum intr_level old_level = intr_disable ();
+
+  if (!alloc)
+    {
+      stats->free_cnt++;
+      stats->free_pages += page_cnt;
+      stats->used_cnt -= page_cnt;
+    }
+  else if (page_cnt == 0)
+    stats->fail_cnt++;
+  else
+    {
+      stats->alloc_cnt++;
+      stats->alloc_pages += page_cnt;
+      stats->used_cnt += page_cnt;
+      if (stats->used_cnt > stats->peak_used_cnt)
+        stats->peak_used_cnt = stats->used_cnt;
+    }
+  intr_set_level (old_level);
+}
+
+/* Prints the statistics for the pool identified by POOL_ID,
+   labeled NAME. */
+static void
+print_pool_stats (const char *name, enum memstat_pool pool_id) 
+{
+  struct palloc_stats s;
+  int i;
+
+  palloc_get_stats (pool_id, &s);
+  printf ("Palloc: %s pool: %"PRIu32"/%"PRIu32" pages used "
+          "(peak %"PRIu32"), %"PRIu32" pre-zeroed, "
+          "largest free run %"PRIu32"\n",
+          name, s.used_cnt, s.page_cnt, s.peak_used_cnt, s.zeroed_cnt,
+          s.largest_free_run);
+  printf ("Palloc: %s pool: %"PRIu64" allocs (%"PRIu64" pages), "
+          "%"PRIu64" frees (%"PRIu64" pages), %"PRIu64" failures, "
+          "%"PRIu64" zeroed hits, %"PRIu64" lock cycles in %"PRIu64
+          " acquisitions\n",
+          name, s.alloc_cnt, s.alloc_pages, s.free_cnt, s.free_pages,
+          s.fail_cnt, s.zero_hit_cnt, s.lock_cycles, s.lock_cnt);
+  for (i = 0; i < MEMSTAT_POLICY_CNT; i++)
+    if (s.policies[i].scan_cnt > 0)
+      printf ("Palloc: %s pool: %s: %"PRIu64" scans, %"PRIu64" wraps, "
+              "%"PRIu64" failed\n",
+              name, i == FIRSTFIT ? "first fit" : "next fit",
+              s.policies[i].scan_cnt, s.policies[i].wrap_cnt,
+              s.policies[i].fail_cnt);
+}
+
+/* Returns the PAGE_CNT pages at PAGES, which need not be the
+   whole of an allocation, to their pool. */
+static void
+release_pages (void *pages, size_t page_cnt) 
+{
+  struct pool *pool = page_to_pool (pages);
+  size_t page_idx = pg_no (pages) - pg_no (pool->base);
+
+#ifndef NDEBUG
+  memset (pages, 0xcc, PGSIZE * page_cnt);
+#endif
+
+  ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+  bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  count_pages (pool, false, page_cnt);
+}
+
+/* Reports PAGE_CNT pages at PAGES, just allocated by CALLER with
+   the given FLAGS, to the allocation tracker, charges them to
+   their owner, and returns them. */
+static void *
+track (void *pages, enum palloc_flags flags UNUSED, size_t page_cnt,
+       const void *caller)
+{
+  tid_t owner = TID_ERROR;
+
+  if (pages == NULL)
+    return NULL;
+
+#ifdef USERPROG
+  /* Kernel pages are charged to the running process, unless the
+     caller accounts for them some other way.  User pages are
+     charged to the process that maps them instead. */
+  if (!(flags & (PAL_USER | PAL_UNCHARGED)))
+    owner = thread_current ()->tid;
+#endif
+  if (memtrack_alloc (MEMTRACK_PAGES, caller, pages, PGSIZE * page_cnt,
+                      owner))
+    charge_pages (owner, page_cnt);
+  return pages;
+}
+
+/* Charges thread OWNER for PAGE_CNT more kernel pages, or
+   credits it if PAGE_CNT is negative.  Does nothing if OWNER is
+   TID_ERROR. */
+static void
+charge_pages (tid_t owner UNUSED, int page_cnt UNUSED) 
+{
+#ifdef USERPROG
+  if (owner != TID_ERROR)
+    memacct_kernel_pages (owner, page_cnt);
+#endif
+}
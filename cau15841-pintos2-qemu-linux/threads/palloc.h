@@ -1,6 +1,8 @@
 #ifndef THREADS_PALLOC_H
 #define THREADS_PALLOC_H
 
+#include <memstat.h>
+#include <stdbool.h>
 #include <stddef.h>
 
 /* How to allocate pages. */
@@ -8,7 +10,8 @@ enum palloc_flags
   {
     PAL_ASSERT = 001,           /* Panic on failure. */
     PAL_ZERO = 002,             /* Zero page contents. */
-    PAL_USER = 004              /* User page. */
+    PAL_USER = 004,             /* User page. */
+    PAL_UNCHARGED = 010         /* Not charged as kernel pages. */
   };
 //어떤 할당 정책을 펼친것인가
 enum polloc_policys
@@ -16,13 +19,20 @@ enum polloc_policys
   FIRSTFIT = 0,
   NEXTFIT = 1
   
-}
+};
 
 void palloc_init (size_t user_page_limit);
 void *palloc_get_page (enum palloc_flags);
 void *palloc_get_multiple (enum palloc_flags, size_t page_cnt);
+void *palloc_get_multiple_for (enum palloc_flags, size_t page_cnt,
+                               const void *caller);
 void palloc_free_page (void *);
 void palloc_free_multiple (void *, size_t page_cnt);
+bool palloc_extend (void *, size_t page_cnt, size_t extra_cnt);
+void palloc_shrink (void *, size_t page_cnt, size_t new_cnt);
+bool palloc_idle_zero (void);
+bool palloc_get_stats (enum memstat_pool, struct palloc_stats *);
+void palloc_print_stats (void);
 
 
 #endif /* threads/palloc.h */
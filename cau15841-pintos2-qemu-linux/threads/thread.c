@@ -7,11 +7,13 @@
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #ifdef USERPROG
+#include "userprog/memacct.h"
 #include "userprog/process.h"
 #endif
 
@@ -193,6 +195,7 @@ thread_create (const char *name, int priority,
     }
   t->next_fd = 2;
   t->fd_table -= t->next_fd;
+  memacct_inherit (t);
     
   list_push_back (&thread_current ()->child_list, &t->child_elem);
 #endif
@@ -316,6 +319,10 @@ thread_exit (void)
   process_exit ();
 #endif
 
+  /* Give our cached malloc() blocks back before our struct thread
+     goes away. */
+  malloc_magazine_flush (&thread_current ()->magazine);
+
   /* Remove thread from all threads list, set our status to dying,
      and schedule another process.  That process will destroy us
      when it calls thread_schedule_tail(). */
@@ -424,10 +431,21 @@ idle (void *idle_started_ UNUSED)
 
   for (;;) 
     {
+      bool zeroed;
+
       /* Let someone else run. */
       intr_disable ();
       thread_block ();
 
+      /* Nobody else wants the CPU, so zero a free page ahead of
+         time for a later PAL_ZERO allocation.  Then go back and
+         check for other work, one page at a time. */
+      intr_enable ();
+      zeroed = palloc_idle_zero ();
+      intr_disable ();
+      if (zeroed)
+        continue;
+
       /* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -499,6 +517,11 @@ init_thread (struct thread *t, const char *name, int priority)
   sema_init (&t->wait_sema, 0);
   sema_init (&t->destroy_sema, 0);
   sema_init (&t->load_sema, 0);
+  t->mem.user_page_limit = MEMSTAT_NO_LIMIT;
+  t->child_page_limit = MEMSTAT_NO_LIMIT;
+#endif
+#ifdef VM
+  list_init (&t->mappings);
 #endif
     
   old_level = intr_disable ();
@@ -3,8 +3,10 @@
 
 #include <debug.h>
 #include <list.h>
+#include <memstat.h>
 #include <stdint.h>
 #include "synch.h"
+#include "threads/malloc.h"
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -98,6 +100,9 @@ struct thread
     struct list_elem child_elem;        /* List element for child thread list. */
     struct list child_list;             /* Its child thread list. */
 
+    /* Owned by malloc.c. */
+    struct malloc_magazine magazine;    /* Cached free blocks. */
+
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
     uint32_t *pagedir;                  /* Page directory. */
@@ -110,6 +115,30 @@ struct thread
       
     int next_fd;
     struct file **fd_table;
+
+    /* Owned by userprog/memacct.c. */
+    struct proc_memstat mem;            /* Memory charged to process. */
+    uint32_t child_page_limit;          /* USER_PAGE_LIMIT for children. */
+#endif
+
+#ifdef VM
+    /* Owned by vm/page.c. */
+    struct hash *pages;                 /* Supplemental page table. */
+    struct lock pages_lock;             /* Held to change PAGES. */
+    struct file *exec_file;             /* Executable, for demand paging. */
+    void *user_esp;                     /* User stack pointer on entry to
+                                           the current system call. */
+    struct list fault_streams;          /* Fault-around state of each
+                                           executable segment. */
+
+    /* Owned by vm/mmap.c. */
+    struct list mappings;               /* Memory-mapped files. */
+    int next_mapid;                     /* Next mapping identifier. */
+
+    /* Owned by vm/wset.c. */
+    struct list_elem wset_elem;         /* List element for sampled
+                                           processes. */
+    struct proc_wsstat wsstat;          /* Working-set estimate. */
 #endif
 
     /* Owned by thread.c. */
@@ -2,8 +2,13 @@
 #include <inttypes.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
+#include "userprog/syscall.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -148,6 +153,44 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
+#ifdef VM
+  /* Bring in a page of the process's address space that is not
+     resident yet.  This also covers the kernel touching a user
+     buffer on behalf of a system call. */
+  if (not_present && is_user_vaddr (fault_addr)
+      && page_in (fault_addr, write))
+    return;
+
+  /* A push, or a local variable, just past the end of the stack.
+     A fault in the kernel comes from a system call touching a
+     user buffer, so use the stack pointer saved on entry. */
+  if (not_present && is_user_vaddr (fault_addr)
+      && page_grow_stack (fault_addr,
+                          user ? f->esp : thread_current ()->user_esp)
+      && page_in (fault_addr, write))
+    return;
+
+  /* A write to a page shared copy-on-write after fork(). */
+  if (!not_present && write && is_user_vaddr (fault_addr)
+      && page_unshare (fault_addr))
+    return;
+#endif
+
+  /* A system call touched a user address that is not mapped, or
+     not writable, through get_user() or put_user() in
+     userprog/syscall.c.  Those put the address to resume at in
+     EAX; return -1 there so the system call can fail cleanly.
+     Any other kernel fault on a user address is a kernel bug,
+     and panics below. */
+  if (!user && is_user_vaddr (fault_addr)
+      && (const char *) f->eip >= user_access_begin
+      && (const char *) f->eip < user_access_end)
+    {
+      f->eip = (void (*) (void)) f->eax;
+      f->eax = 0xffffffff;
+      return;
+    }
+
   /* To implement virtual memory, delete the rest of the function
      body, and replace it with code that brings in the page to
      which fault_addr refers. */
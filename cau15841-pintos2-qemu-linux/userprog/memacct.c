@@ -0,0 +1,161 @@
+#include "userprog/memacct.h"
+#include <debug.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+static struct thread *find_thread (tid_t);
+
+/* Per-process memory accounting.
+
+   Every thread carries a struct proc_memstat.  Resident user
+   pages are charged to the process whose page is mapped, which
+   need not be the running thread: the thread that evicts a page
+   credits the page's owner.  Those counters are therefore only
+   changed with interrupts off.  Page tables are charged to the
+   running process, which alone creates and destroys them.
+
+   Kernel pool pages and heap blocks are charged to the thread
+   that allocated them.  The allocation tracker (see
+   threads/memtrack.c) remembers that thread, so that whichever
+   thread frees the memory credits the one that allocated it.
+   Memory freed after its owner has exited is credited to
+   nobody.  Page table pages and malloc() arena pages are not
+   counted as kernel pages, since they are counted as page table
+   pages and heap bytes instead.
+
+   A process may not allocate a frame for a new page while it
+   holds its limit of resident user pages; the frame allocator
+   evicts one of the process's own pages instead (see
+   vm/frame.c), or without VM the page cannot be installed. */
+
+/* Gives CHILD, a new thread created by the running one, the
+   limit that the running thread set for its children.  The
+   child passes the same limit on to its own children. */
+void
+memacct_inherit (struct thread *child)
+{
+  uint32_t limit = thread_current ()->child_page_limit;
+
+  child->mem.user_page_limit = limit;
+  child->child_page_limit = limit;
+}
+
+/* Limits the processes that the running process creates from
+   now on, with exec() or fork(), to PAGE_CNT resident user
+   pages each. */
+void
+memacct_set_child_limit (unsigned page_cnt)
+{
+  thread_current ()->child_page_limit = page_cnt;
+}
+
+/* Charges process T for DELTA more resident user pages, or
+   credits it if DELTA is negative. */
+void
+memacct_user_pages (struct thread *t, int delta)
+{
+  struct proc_memstat *mem = &t->mem;
+  enum intr_level old_level = intr_disable ();
+
+  ASSERT (delta >= 0 || mem->user_pages >= (uint32_t) -delta);
+  mem->user_pages += delta;
+  if (mem->user_pages > mem->peak_user_pages)
+    mem->peak_user_pages = mem->user_pages;
+  intr_set_level (old_level);
+}
+
+/* Returns true if process T has as many resident user pages as
+   it is allowed. */
+bool
+memacct_user_full (const struct thread *t)
+{
+  return t->mem.user_pages >= t->mem.user_page_limit;
+}
+
+/* Records that one of process T's pages was evicted to make room
+   for another of its pages. */
+void
+memacct_reclaimed (struct thread *t)
+{
+  enum intr_level old_level = intr_disable ();
+  t->mem.reclaim_cnt++;
+  intr_set_level (old_level);
+}
+
+/* Charges the running process for DELTA more page directory or
+   page table pages, or credits it if DELTA is negative. */
+void
+memacct_pt_pages (int delta)
+{
+  thread_current ()->mem.pt_pages += delta;
+}
+
+/* Charges thread OWNER for DELTA more kernel pool pages, or
+   credits it if DELTA is negative.  Does nothing if OWNER has
+   exited. */
+void
+memacct_kernel_pages (tid_t owner, int delta)
+{
+  enum intr_level old_level = intr_disable ();
+  struct thread *t = find_thread (owner);
+
+  if (t != NULL)
+    {
+      ASSERT (delta >= 0 || t->mem.kernel_pages >= (uint32_t) -delta);
+      t->mem.kernel_pages += delta;
+    }
+  intr_set_level (old_level);
+}
+
+/* Charges thread OWNER for DELTA more bytes of kernel heap, or
+   credits it if DELTA is negative.  Does nothing if OWNER has
+   exited. */
+void
+memacct_heap_bytes (tid_t owner, int delta)
+{
+  enum intr_level old_level = intr_disable ();
+  struct thread *t = find_thread (owner);
+
+  if (t != NULL)
+    {
+      ASSERT (delta >= 0 || t->mem.heap_bytes >= (uint32_t) -delta);
+      t->mem.heap_bytes += delta;
+    }
+  intr_set_level (old_level);
+}
+
+/* A search for a thread by tid, for find_thread(). */
+struct thread_search
+  {
+    tid_t tid;                  /* Thread identifier to look for. */
+    struct thread *thread;      /* Thread found, or null. */
+  };
+
+/* thread_foreach() helper for find_thread(). */
+static void
+match_tid (struct thread *t, void *search_)
+{
+  struct thread_search *search = search_;
+
+  if (t->tid == search->tid)
+    search->thread = t;
+}
+
+/* Returns the live thread with the given TID, or a null pointer
+   if there is none.  Usually that is the running thread, so it
+   is checked first.  Interrupts must be off. */
+static struct thread *
+find_thread (tid_t tid)
+{
+  struct thread *cur = thread_current ();
+  struct thread_search search;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (cur->tid == tid)
+    return cur;
+  search.tid = tid;
+  search.thread = NULL;
+  thread_foreach (match_tid, &search);
+  return search.thread;
+}
@@ -0,0 +1,18 @@
+#ifndef USERPROG_MEMACCT_H
+#define USERPROG_MEMACCT_H
+
+#include <stdbool.h>
+#include "threads/thread.h"
+
+void memacct_inherit (struct thread *child);
+void memacct_set_child_limit (unsigned page_cnt);
+
+void memacct_user_pages (struct thread *, int delta);
+bool memacct_user_full (const struct thread *);
+void memacct_reclaimed (struct thread *);
+
+void memacct_pt_pages (int delta);
+void memacct_kernel_pages (tid_t owner, int delta);
+void memacct_heap_bytes (tid_t owner, int delta);
+
+#endif /* userprog/memacct.h */
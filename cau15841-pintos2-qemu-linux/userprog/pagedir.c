@@ -5,20 +5,36 @@
 #include "threads/init.h"
 #include "threads/pte.h"
 #include "threads/palloc.h"
+#include "threads/thread.h"
+#include "userprog/memacct.h"
 
 static uint32_t *active_pd (void);
-static void invalidate_pagedir (uint32_t *);
+static void invalidate_page (uint32_t *, const void *);
 
 /* Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
    Returns the new page directory, or a null pointer if memory
-   allocation fails. */
+   allocation fails.
+
+   Only the kernel's PDEs are copied from init_page_dir.  They
+   point to the same page tables and 4 MB pages, so the kernel
+   mapping is shared, never duplicated.
+
+   A page directory is only ever created, extended with page
+   tables and destroyed by the process that owns it, so those
+   pages are charged to the running process, as page table pages
+   rather than as kernel pages. */
 uint32_t *
 pagedir_create (void) 
 {
-  uint32_t *pd = palloc_get_page (0);
+  uint32_t *pd = palloc_get_page (PAL_ZERO | PAL_UNCHARGED);
   if (pd != NULL)
-    memcpy (pd, init_page_dir, PGSIZE);
+    {
+      size_t kernel_pde = pd_no (PHYS_BASE);
+      memcpy (pd + kernel_pde, init_page_dir + kernel_pde,
+              PGSIZE - kernel_pde * sizeof *pd);
+      memacct_pt_pages (1);
+    }
   return pd;
 }
 
@@ -28,6 +44,7 @@ void
 pagedir_destroy (uint32_t *pd) 
 {
   uint32_t *pde;
+  int pt_cnt = 1, user_cnt = 0;
 
   if (pd == NULL)
     return;
@@ -41,10 +58,16 @@ pagedir_destroy (uint32_t *pd)
         
         for (pte = pt; pte < pt + PGSIZE / sizeof *pte; pte++)
           if (*pte & PTE_P) 
-            palloc_free_page (pte_get_page (*pte));
+            {
+              palloc_free_page (pte_get_page (*pte));
+              user_cnt++;
+            }
         palloc_free_page (pt);
+        pt_cnt++;
       }
   palloc_free_page (pd);
+  memacct_pt_pages (-pt_cnt);
+  memacct_user_pages (thread_current (), -user_cnt);
 }
 
 /* Returns the address of the page table entry for virtual
@@ -70,11 +93,12 @@ lookup_page (uint32_t *pd, const void *vaddr, bool create)
     {
       if (create)
         {
-          pt = palloc_get_page (PAL_ZERO);
+          pt = palloc_get_page (PAL_ZERO | PAL_UNCHARGED);
           if (pt == NULL) 
             return NULL; 
       
           *pde = pde_create (pt);
+          memacct_pt_pages (1);
         }
       else
         return NULL;
@@ -152,7 +176,27 @@ pagedir_clear_page (uint32_t *pd, void *upage)
   if (pte != NULL && (*pte & PTE_P) != 0)
     {
       *pte &= ~PTE_P;
-      invalidate_pagedir (pd);
+      invalidate_page (pd, upage);
+    }
+}
+
+/* Sets the writable bit to WRITABLE in the PTE for user virtual
+   page UPAGE in PD, if UPAGE is mapped. */
+void
+pagedir_set_writable (uint32_t *pd, const void *upage, bool writable) 
+{
+  uint32_t *pte;
+
+  ASSERT (is_user_vaddr (upage));
+
+  pte = lookup_page (pd, upage, false);
+  if (pte != NULL && (*pte & PTE_P) != 0)
+    {
+      if (writable)
+        *pte |= PTE_W;
+      else
+        *pte &= ~(uint32_t) PTE_W;
+      invalidate_page (pd, upage);
     }
 }
 
@@ -180,7 +224,7 @@ pagedir_set_dirty (uint32_t *pd, const void *vpage, bool dirty)
       else 
         {
           *pte &= ~(uint32_t) PTE_D;
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
@@ -209,18 +253,24 @@ pagedir_set_accessed (uint32_t *pd, const void *vpage, bool accessed)
       else 
         {
           *pte &= ~(uint32_t) PTE_A; 
-          invalidate_pagedir (pd);
+          invalidate_page (pd, vpage);
         }
     }
 }
 
 /* Loads page directory PD into the CPU's page directory base
-   register. */
+   register, or init_page_dir if PD is null.  Does nothing if PD
+   is already active: loading CR3 flushes every non-global TLB
+   entry, and the entries for PD are still valid because every
+   change to an active page directory invalidates the affected
+   page itself. */
 void
 pagedir_activate (uint32_t *pd) 
 {
   if (pd == NULL)
     pd = init_page_dir;
+  if (pd == active_pd ())
+    return;
 
   /* Store the physical address of the page directory into CR3
      aka PDBR (page directory base register).  This activates our
@@ -245,19 +295,20 @@ active_pd (void)
 
 /* Seom page table changes can cause the CPU's translation
    lookaside buffer (TLB) to become out-of-sync with the page
-   table.  When this happens, we have to "invalidate" the TLB by
-   re-activating it.
+   table.  When this happens, we have to "invalidate" the TLB
+   entry for the page that changed.
 
-   This function invalidates the TLB if PD is the active page
-   directory.  (If PD is not active then its entries are not in
-   the TLB, so there is no need to invalidate anything.) */
+   This function invalidates the TLB entry for VADDR if PD is the
+   active page directory.  (If PD is not active then its entries
+   are not in the TLB, so there is no need to invalidate
+   anything.)  Unlike reloading CR3, this leaves the rest of the
+   TLB alone. */
 static void
-invalidate_pagedir (uint32_t *pd) 
+invalidate_page (uint32_t *pd, const void *vaddr) 
 {
   if (active_pd () == pd) 
     {
-      /* Re-activating PD clears the TLB.  See [IA32-v3a] 3.12
-         "Translation Lookaside Buffers (TLBs)". */
-      pagedir_activate (pd);
+      /* See [IA32-v2a] "INVLPG--Invalidate TLB Entry". */
+      asm volatile ("invlpg (%0)" : : "r" (vaddr) : "memory");
     } 
 }
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "userprog/gdt.h"
+#include "userprog/memacct.h"
 #include "userprog/pagedir.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
@@ -17,6 +18,10 @@
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
 
 /* Parameters for user program execution
    len: the length of a program command line 
@@ -106,6 +111,99 @@ start_process (void *_params)
   NOT_REACHED ();
 }
 
+#ifdef VM
+/* Parameters for fork(). */
+struct fork_params
+  {
+    struct thread *parent;      /* Process being forked. */
+    struct intr_frame *if_;     /* Its user context at the system call. */
+  };
+
+static thread_func start_fork NO_RETURN;
+static bool copy_process (struct thread *parent);
+
+/* Creates a child of the current process that resumes from
+   system call frame IF_ with a copy of the current process's
+   address space and open files.  Memory is shared copy-on-write,
+   so forking does not copy any page the child does not write.
+   Returns the child's thread id, or TID_ERROR if it could not be
+   created. */
+tid_t
+process_fork (struct intr_frame *if_)
+{
+  struct fork_params params;
+  struct thread *child;
+  tid_t tid;
+
+  params.parent = thread_current ();
+  params.if_ = if_;
+  tid = thread_create (thread_name (), PRI_DEFAULT, start_fork, &params);
+  if (tid == TID_ERROR)
+    return TID_ERROR;
+
+  /* PARAMS lives on our stack, and the child copies our address
+     space, so we may not run until it is done. */
+  child = thread_get_child (tid);
+  ASSERT (child);
+  sema_down (&child->load_sema);
+  return child->load_succeeded ? tid : TID_ERROR;
+}
+
+/* A thread function that copies the forking process and starts
+   running it, returning 0 from fork(). */
+static void
+start_fork (void *params_)
+{
+  struct fork_params *params = params_;
+  struct thread *t = thread_current ();
+  struct intr_frame if_;
+
+  memcpy (&if_, params->if_, sizeof if_);
+  if_.eax = 0;
+
+  t->load_succeeded = copy_process (params->parent);
+  sema_up (&t->load_sema);
+  if (!t->load_succeeded)
+    thread_exit ();
+
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* Gives the current thread a copy of PARENT's address space and
+   open files.  Returns true if successful, false on failure. */
+static bool
+copy_process (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  int fd;
+
+  t->pagedir = pagedir_create ();
+  if (t->pagedir == NULL)
+    return false;
+  process_activate ();
+  if (!page_table_create ())
+    return false;
+
+  t->exec_file = file_reopen (parent->exec_file);
+  if (t->exec_file == NULL)
+    return false;
+  file_deny_write (t->exec_file);
+
+  for (fd = 2; fd < parent->next_fd; fd++)
+    if (parent->fd_table[fd] != NULL)
+      {
+        t->fd_table[fd] = file_reopen (parent->fd_table[fd]);
+        if (t->fd_table[fd] == NULL)
+          return false;
+        file_seek (t->fd_table[fd], file_tell (parent->fd_table[fd]));
+      }
+  t->next_fd = parent->next_fd;
+
+  return mmap_copy (parent) && page_table_copy (parent);
+}
+#endif
+
 /* Waits for thread TID to die and returns its exit status.  If
    it was terminated by the kernel (i.e. killed due to an
    exception), returns -1.  If TID is invalid or if it was not a
@@ -141,6 +239,16 @@ process_exit (void)
 
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
+#ifdef VM
+  /* Release the address space while the page directory still
+     maps it, writing back mapped files, then the executable that
+     backs its code pages. */
+  mmap_unmap_all ();
+  page_table_destroy ();
+  file_close (cur->exec_file);
+  cur->exec_file = NULL;
+#endif
+
   pd = cur->pagedir;
   if (pd != NULL) 
     {
@@ -165,8 +273,16 @@ process_activate (void)
 {
   struct thread *t = thread_current ();
 
-  /* Activate thread's page tables. */
-  pagedir_activate (t->pagedir);
+  /* Activate thread's page tables.  A kernel thread never touches
+     user memory, so it simply keeps running on whatever page
+     directory is already loaded: every page directory maps the
+     kernel identically.  That way a process that blocks, lets the
+     idle thread or another kernel thread run, and is then resumed
+     never reloads CR3 at all.  A process's page directory cannot
+     be freed while it is loaded because process_exit() switches
+     to init_page_dir first. */
+  if (t->pagedir != NULL)
+    pagedir_activate (t->pagedir);
 
   /* Set thread's kernel stack for use in processing
      interrupts. */
@@ -297,6 +413,10 @@ load (struct uprg_params *params, void (**eip) (void), void **esp)
   if (t->pagedir == NULL) 
     goto done;
   process_activate ();
+#ifdef VM
+  if (!page_table_create ())
+    goto done;
+#endif
 
   /* Open executable file. */
   file_name = params->cmdline;
@@ -390,13 +510,27 @@ load (struct uprg_params *params, void (**eip) (void), void **esp)
 
  done:
   /* We arrive here whether the load is successful or not. */
+#ifdef VM
+  /* Code and data pages are read from the executable on demand,
+     so keep it open, and unmodifiable, for the process's
+     lifetime. */
+  if (success)
+    {
+      file_deny_write (file);
+      t->exec_file = file;
+      return success;
+    }
+#endif
   file_close (file);
   return success;
 }
 
 /* load() helpers. */
 
+#ifndef VM
 static bool install_page (void *upage, void *kpage, bool writable);
+#endif
+static bool map_stack_page (void);
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -456,7 +590,10 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
    user process if WRITABLE is true, read-only otherwise.
 
    Return true if successful, false if a memory allocation error
-   or disk read error occurs. */
+   or disk read error occurs.
+
+   With VM, the pages are only recorded in the supplemental page
+   table here and read in when they are first touched. */
 static bool
 load_segment (struct file *file, off_t ofs, uint8_t *upage,
               uint32_t read_bytes, uint32_t zero_bytes, bool writable) 
@@ -465,6 +602,38 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
+#ifdef VM
+  struct fault_stream *stream = page_add_stream ();
+
+  if (stream == NULL)
+    return false;
+  while (read_bytes > 0 || zero_bytes > 0) 
+    {
+      size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
+      size_t page_zero_bytes = PGSIZE - page_read_bytes;
+      bool success;
+
+      /* Read-only pages are shared with every other process
+         running this executable, which keeps it open and
+         unwritable until they are gone. */
+      if (page_read_bytes > 0 && !writable)
+        success = page_add_text (upage, file_get_inode (file), ofs,
+                                 page_read_bytes, stream);
+      else if (page_read_bytes > 0)
+        success = page_add_file (upage, file, ofs, page_read_bytes, writable,
+                                 stream);
+      else
+        success = page_add_zero (upage, writable);
+      if (!success)
+        return false;
+
+      read_bytes -= page_read_bytes;
+      zero_bytes -= page_zero_bytes;
+      ofs += page_read_bytes;
+      upage += PGSIZE;
+    }
+  return true;
+#else
   file_seek (file, ofs);
   while (read_bytes > 0 || zero_bytes > 0) 
     {
@@ -500,6 +669,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
       upage += PGSIZE;
     }
   return true;
+#endif
 }
 
 /* Create a minimal stack by mapping a zeroed page at the top of
@@ -507,16 +677,13 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 static bool
 setup_stack (struct uprg_params *params, void **esp) 
 {
-  uint8_t *kpage;
   bool success = false;
 
   int i, t, argc;
   uint32_t addr; 
 
-  kpage = palloc_get_page (PAL_USER | PAL_ZERO);
-  if (kpage != NULL) 
     {
-      success = install_page (((uint8_t *) PHYS_BASE) - PGSIZE, kpage, true);
+      success = map_stack_page ();
       if (success) {
         *esp = PHYS_BASE;
 
@@ -634,12 +801,38 @@ setup_stack (struct uprg_params *params, void **esp)
         printf("0x%8X: points to ret, 0x%X\n", (uint32_t) *esp, *((uint32_t *) *esp));
 #endif 
       }
-      else
-        palloc_free_page (kpage);
     }
   return success;
 }
 
+/* Maps a zeroed page just below PHYS_BASE for the initial
+   stack.  With VM the page joins the supplemental page table
+   like any other, but is brought in right away, with a frame
+   of its own rather than the zero frame, because the arguments
+   are pushed onto it immediately. */
+static bool
+map_stack_page (void)
+{
+  uint8_t *upage = ((uint8_t *) PHYS_BASE) - PGSIZE;
+#ifdef VM
+  if (!page_add_zero (upage, true) || !page_lock (upage, true))
+    return false;
+  page_unlock (upage);
+  return true;
+#else
+  uint8_t *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+  if (kpage == NULL)
+    return false;
+  if (!install_page (upage, kpage, true))
+    {
+      palloc_free_page (kpage);
+      return false;
+    }
+  return true;
+#endif
+}
+
+#ifndef VM
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -647,8 +840,9 @@ setup_stack (struct uprg_params *params, void **esp)
    UPAGE must not already be mapped.
    KPAGE should probably be a page obtained from the user pool
    with palloc_get_page().
-   Returns true on success, false if UPAGE is already mapped or
-   if memory allocation fails. */
+   Returns true on success, false if UPAGE is already mapped, if
+   the process already has as many resident pages as its limit
+   allows, or if memory allocation fails. */
 static bool
 install_page (void *upage, void *kpage, bool writable)
 {
@@ -656,6 +850,11 @@ install_page (void *upage, void *kpage, bool writable)
 
   /* Verify that there's not already a page at that virtual
      address, then map our page there. */
-  return (pagedir_get_page (t->pagedir, upage) == NULL
-          && pagedir_set_page (t->pagedir, upage, kpage, writable));
+  if (memacct_user_full (t)
+      || pagedir_get_page (t->pagedir, upage) != NULL
+      || !pagedir_set_page (t->pagedir, upage, kpage, writable))
+    return false;
+  memacct_user_pages (t, 1);
+  return true;
 }
+#endif
@@ -1,7 +1,9 @@
 #include "userprog/syscall.h"
 #include "userprog/process.h"
+#include "userprog/memacct.h"
 #include "userprog/pagedir.h"
 
+#include <ring.h>
 #include <stdio.h>
 #include <string.h>
 #include <syscall-nr.h>
@@ -10,6 +12,7 @@
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/synch.h"
 
 #include "filesys/filesys.h"
@@ -19,9 +22,18 @@
 
 #include "devices/shutdown.h"
 #include "devices/input.h"
+#include "devices/timer.h"
 
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#include "vm/wset.h"
+#endif
 
-struct lock file_lock;
+
+/* Keeps one read() from the console from being interleaved with
+   another.  The file system does its own locking. */
+static struct lock stdin_lock;
 
 static void syscall_handler (struct intr_frame *);
 static void halt (void);
@@ -34,131 +46,365 @@ static int open (const char *);
 static int filesize (int);
 static int read (int, void *, unsigned);
 static int write (int, const void *, unsigned);
+static int readv (int, const struct iovec *, int);
+static int writev (int, const struct iovec *, int);
+static int pread (int, void *, unsigned, int32_t);
+static int pwrite (int, const void *, unsigned, int32_t);
+static int ring_enter (struct ring *, struct intr_frame *);
+static int copy_file_range (int, int, unsigned);
 static void seek (int, unsigned);
 static unsigned tell (int);
 static void close (int);
+static bool memstat (enum memstat_pool, struct palloc_stats *);
+static bool memusage (struct proc_memstat *);
+#ifdef VM
+static int mmap (int, void *);
+static void munmap (int);
+static bool wsstat (struct proc_wsstat *);
+#endif
+
+static bool pin_iovec (const struct iovec *, int cnt, bool write);
+#ifdef VM
+static void unpin_iovec (const struct iovec *, int cnt);
+#endif
+
+/* Kinds of system call argument. */
+enum arg_kind
+  {
+    ARG_INT,                    /* Integer or other plain value. */
+    ARG_STRING,                 /* String, copied into the kernel. */
+    ARG_BUFFER,                 /* Buffer, checked to lie in user memory. */
+    ARG_PINNED                  /* Buffer, also locked into memory. */
+  };
+
+/* A system call argument. */
+struct syscall_arg
+  {
+    enum arg_kind kind;         /* Kind of argument. */
+    int len_arg;                /* Buffers: index of the argument
+                                   with the length, or -1. */
+    unsigned size;              /* Buffers: length if LEN_ARG is -1. */
+  };
+
+#define INT_ARG {ARG_INT, -1, 0}
+#define STRING_ARG {ARG_STRING, -1, 0}
+#define BUFFER_ARG(LEN_ARG) {ARG_BUFFER, LEN_ARG, 0}
+#define PINNED_ARG(LEN_ARG) {ARG_PINNED, LEN_ARG, 0}
+#define OBJECT_ARG(TYPE) {ARG_BUFFER, -1, sizeof (TYPE)}
+
+/* Most arguments a system call takes. */
+#define SYSCALL_ARG_MAX 4
+
+/* Carries out a system call, given its validated arguments and
+   the caller's interrupt frame, and returns its result. */
+typedef int32_t syscall_func (int32_t *args, struct intr_frame *);
+
+/* A system call.  syscall_handler() copies and validates the
+   arguments as described here before calling FUNC, and releases
+   them afterward, so implementations see strings as kernel
+   copies and pinned buffers as resident. */
+struct syscall
+  {
+    const char *name;           /* Name, for statistics. */
+    syscall_func *func;         /* Implementation. */
+    int arg_cnt;                /* Number of arguments. */
+    struct syscall_arg args[SYSCALL_ARG_MAX]; /* The arguments. */
+    bool batchable;             /* May be submitted through a ring? */
+
+    /* Statistics, updated with interrupts off. */
+    uint64_t call_cnt;          /* Number of calls. */
+    int64_t ticks;              /* Timer ticks spent in FUNC. */
+  };
+
+static syscall_func sys_halt, sys_exit, sys_exec, sys_wait, sys_create,
+  sys_remove, sys_open, sys_filesize, sys_read, sys_write, sys_seek,
+  sys_tell, sys_close, sys_memstat, sys_memusage, sys_memlimit, sys_readv,
+  sys_writev, sys_pread, sys_pwrite, sys_ring_enter,
+  sys_copy_file_range;
+#ifdef VM
+static syscall_func sys_mmap, sys_munmap, sys_fork, sys_wsstat;
+#endif
+
+/* System calls, indexed by number.  Numbers without an entry
+   kill the caller.  Those marked batchable neither end nor
+   replace the process, so ring_enter() may run them. */
+static struct syscall syscalls[] =
+  {
+    [SYS_HALT] = {"halt", sys_halt, 0, {}},
+    [SYS_EXIT] = {"exit", sys_exit, 1, {INT_ARG}},
+    [SYS_EXEC] = {"exec", sys_exec, 1, {STRING_ARG}},
+    [SYS_WAIT] = {"wait", sys_wait, 1, {INT_ARG}},
+    [SYS_CREATE] = {"create", sys_create, 2, {STRING_ARG, INT_ARG}, true},
+    [SYS_REMOVE] = {"remove", sys_remove, 1, {STRING_ARG}, true},
+    [SYS_OPEN] = {"open", sys_open, 1, {STRING_ARG}, true},
+    [SYS_FILESIZE] = {"filesize", sys_filesize, 1, {INT_ARG}, true},
+    [SYS_READ] = {"read", sys_read, 3,
+                  {INT_ARG, PINNED_ARG (2), INT_ARG}, true},
+    [SYS_WRITE] = {"write", sys_write, 3,
+                   {INT_ARG, BUFFER_ARG (2), INT_ARG}, true},
+    [SYS_SEEK] = {"seek", sys_seek, 2, {INT_ARG, INT_ARG}, true},
+    [SYS_TELL] = {"tell", sys_tell, 1, {INT_ARG}, true},
+    [SYS_CLOSE] = {"close", sys_close, 1, {INT_ARG}, true},
+#ifdef VM
+    [SYS_MMAP] = {"mmap", sys_mmap, 2, {INT_ARG, INT_ARG}},
+    [SYS_MUNMAP] = {"munmap", sys_munmap, 1, {INT_ARG}},
+#endif
+    [SYS_MEMSTAT] = {"memstat", sys_memstat, 2,
+                     {INT_ARG, OBJECT_ARG (struct palloc_stats)}},
+#ifdef VM
+    [SYS_FORK] = {"fork", sys_fork, 0, {}},
+#endif
+    [SYS_MEMUSAGE] = {"memusage", sys_memusage, 1,
+                      {OBJECT_ARG (struct proc_memstat)}},
+    [SYS_MEMLIMIT] = {"memlimit", sys_memlimit, 1, {INT_ARG}},
+#ifdef VM
+    [SYS_WSSTAT] = {"wsstat", sys_wsstat, 1,
+                    {OBJECT_ARG (struct proc_wsstat)}},
+#endif
+    [SYS_READV] = {"readv", sys_readv, 3,
+                   {INT_ARG, INT_ARG, INT_ARG}, true},
+    [SYS_WRITEV] = {"writev", sys_writev, 3,
+                    {INT_ARG, INT_ARG, INT_ARG}, true},
+    [SYS_PREAD] = {"pread", sys_pread, 4,
+                   {INT_ARG, PINNED_ARG (2), INT_ARG, INT_ARG}, true},
+    [SYS_PWRITE] = {"pwrite", sys_pwrite, 4,
+                    {INT_ARG, BUFFER_ARG (2), INT_ARG, INT_ARG}, true},
+    [SYS_RING_ENTER] = {"ring_enter", sys_ring_enter, 1,
+                        {OBJECT_ARG (struct ring)}},
+    [SYS_COPY_FILE_RANGE] = {"copy_file_range", sys_copy_file_range, 3,
+                             {INT_ARG, INT_ARG, INT_ARG}, true},
+  };
+
+/* Number of entries in SYSCALLS. */
+#define SYSCALL_CNT (sizeof syscalls / sizeof *syscalls)
 
 
 void
 syscall_init (void) 
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
-  lock_init (&file_lock);
+  lock_init (&stdin_lock);
 }
 
-static inline void
-check_address (void *addr)
+/* The only instructions through which the kernel touches user
+   memory that it has not checked or locked.  They lie between
+   user_access_begin and user_access_end, so that page_fault()
+   can tell their faults from kernel bugs.  Each puts the address
+   to resume at in EAX; a fault there resumes at it with EAX set
+   to -1. */
+int user_get_byte (const uint8_t *uaddr);
+int user_put_byte (uint8_t *udst, uint8_t byte);
+asm (".pushsection .text\n"
+     ".globl user_access_begin, user_access_end\n"
+     ".globl user_get_byte, user_put_byte\n"
+     "user_access_begin:\n"
+     "user_get_byte:\n"
+     "  movl 4(%esp), %edx\n"
+     "  movl $1f, %eax\n"
+     "  movzbl (%edx), %eax\n"
+     "1:ret\n"
+     "user_put_byte:\n"
+     "  movl 4(%esp), %edx\n"
+     "  movb 8(%esp), %cl\n"
+     "  movl $1f, %eax\n"
+     "  movb %cl, (%edx)\n"
+     "1:ret\n"
+     "user_access_end:\n"
+     ".popsection\n");
+
+/* Reads a byte at user virtual address UADDR, which must be
+   below PHYS_BASE.  Returns the byte value if successful, -1 if
+   a page fault occurred. */
+static inline int
+get_user (const uint8_t *uaddr)
 {
-  if (!(is_user_vaddr (addr) && addr >= (void *)0x08048000UL))
-    exit (-1);
+  return user_get_byte (uaddr);
 }
 
-static inline void
-check_address4 (void *addr)
+/* Writes BYTE to user address UDST, which must be below
+   PHYS_BASE.  Returns true if successful, false if a page fault
+   occurred. */
+static inline bool
+put_user (uint8_t *udst, uint8_t byte)
 {
-  check_address (addr);
-  check_address (addr + 3);
+  return user_put_byte (udst, byte) != -1;
 }
 
-static inline void
-get_arguments (void *esp, void *args, int count)
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST.  Returns true if successful, false if part of USRC is not
+   mapped.  USRC must have passed check_user_string_l(). */
+static bool
+copy_in (void *dst_, const void *usrc_, size_t size)
 {
-  ASSERT (1 <= count && count <= 4);
-  while (count--)
-  {
-    check_address4 ((esp += 4));
-    *((int32_t *) args) = *(int32_t *) esp;
-    args += 4;
-  }
+  uint8_t *dst = dst_;
+  const uint8_t *usrc = usrc_;
+
+  for (; size > 0; size--)
+    {
+      int byte = get_user (usrc++);
+      if (byte < 0)
+        return false;
+      *dst++ = byte;
+    }
+  return true;
 }
 
-static inline void
-check_user_string_l (const char *str, unsigned size)
+/* Copies SIZE bytes from kernel address SRC to user address
+   UDST.  Returns true if successful, false if part of UDST is
+   not mapped writable.  UDST must have passed
+   check_user_string_l(). */
+static bool
+copy_out (void *udst_, const void *src_, size_t size)
 {
-  while (size--)
-    check_address ((void *) (str++));  
+  uint8_t *udst = udst_;
+  const uint8_t *src = src_;
+
+  for (; size > 0; size--)
+    if (!put_user (udst++, *src++))
+      return false;
+  return true;
 }
 
 static inline void
-check_user_string (const char *str)
+check_address (void *addr)
 {
-  for (; check_address ((void *) str), *str; str++);
+  if (!(is_user_vaddr (addr) && addr >= (void *)0x08048000UL))
+    exit (-1);
 }
 
-static inline char *
-get_user_string_l (const char *str, unsigned size)
+/* Checks that the SIZE bytes at STR lie in user memory.  Valid
+   user addresses form a single range, so checking the first and
+   last byte covers everything in between.  Whether the pages
+   are mapped is found out when they are accessed, through
+   get_user() and put_user() or by pinning them. */
+static inline void
+check_user_string_l (const char *str, unsigned size)
 {
-  char *buffer = 0;
-  buffer = malloc (size);
-  if (!buffer)
-    return 0;
-  memcpy (buffer, str, size);
-  return buffer;
+  if (size == 0)
+    return;
+  if ((uintptr_t) str + size - 1 < (uintptr_t) str)
+    exit (-1);
+  check_address ((void *) str);
+  check_address ((void *) (str + size - 1));
 }
 
-static inline char *
-get_user_string (const char *str)
+/* Stores the length of the user string STR in *LEN.  Returns
+   false if STR runs into memory that is not mapped. */
+static bool
+user_strlen (const char *str, size_t *len)
 {
-  unsigned size;
-  char *buffer;
-  size = strlen (str) + 1;
-  buffer = get_user_string_l (str, size);
-  return buffer; 
+  int c;
+
+  for (*len = 0; ; (*len)++)
+    {
+      if (!is_user_vaddr (str + *len))
+        return false;
+      c = get_user ((const uint8_t *) str + *len);
+      if (c < 0)
+        return false;
+      if (c == 0)
+        return true;
+    }
 }
 
-static inline void
-free_single_user_string (char **args, int flag, int index)
+#ifndef VM
+/* Touches one byte of every page of the SIZE-byte user buffer
+   BUFFER, so that the kernel can access the buffer directly
+   afterward without faulting.  If WRITE is true, the pages must
+   be writable.  Returns false if part of the buffer is not
+   mapped suitably.  (With VM, pin_user_buffer() does this and
+   keeps the pages in memory too.) */
+static bool
+check_user_buffer (void *buffer, unsigned size, bool write)
 {
-  if (flag & (0b1000 >> index))
+  uint8_t *p = buffer;
+  uint8_t *end = p + size;
+
+  for (; p < end; p = (uint8_t *) pg_round_down (p) + PGSIZE)
     {
-      free (args[index]);
-      args[index] = 0;
+      int byte = get_user (p);
+      if (byte < 0 || (write && !put_user (p, byte)))
+        return false;
     }
+  return true;
 }
+#endif
 
-static inline void
-free_user_strings (char **args, int flag)
+#ifdef VM
+/* Brings the user page UPAGE into memory, growing the stack if
+   UPAGE lies just below it, and locks it there.  If WILL_WRITE
+   is true, the page must be writable.  Returns true if
+   successful, false if UPAGE is not mapped suitably. */
+static bool
+pin_user_page (const void *upage, bool will_write)
 {
-  ASSERT (0 <= flag && flag <= 0b1111);
-  free_single_user_string (args, flag, 0);
-  free_single_user_string (args, flag, 1);
-  free_single_user_string (args, flag, 2);
-  free_single_user_string (args, flag, 3);
+  return ((page_lookup (upage) != NULL
+           || page_grow_stack (upage, thread_current ()->user_esp))
+          && page_lock (upage, will_write));
 }
 
-static inline void
-get_single_user_string (char **args, int flag, int index)
+/* Brings every page of the SIZE-byte user buffer BUFFER into
+   memory and locks it there, so that the kernel can fill it
+   while holding file system locks without taking a page fault,
+   which might need the same locks to read in the page or to
+   write back the page it evicts.  Returns false, with nothing
+   locked, if part of the buffer is not mapped writable.  An
+   empty buffer locks nothing. */
+static bool
+pin_user_buffer (void *buffer, unsigned size)
 {
-  if (flag & (0b1000 >> index))
-    {
-      args[index] = get_user_string (args[index]);
-      if (!args[index])
-        {
-          free_user_strings (args, flag & (0b11110000 >> index));
-          exit(-1);
-        }
-    }
+  uint8_t *upage = pg_round_down (buffer);
+  uint8_t *end = (uint8_t *) buffer + size;
+
+  if (size == 0)
+    return true;
+  for (; upage < end; upage += PGSIZE)
+    if (!pin_user_page (upage, true))
+      {
+        uint8_t *p;
+        for (p = pg_round_down (buffer); p < upage; p += PGSIZE)
+          page_unlock (p);
+        return false;
+      }
+  return true;
 }
 
-static inline void
-check_single_user_string (char **args, int flag, int index)
+/* Unlocks a buffer locked with pin_user_buffer(). */
+static void
+unpin_user_buffer (void *buffer, unsigned size)
 {
-  if (flag & (0b1000 >> index))
-    check_user_string (args[index]);
+  uint8_t *upage = pg_round_down (buffer);
+  uint8_t *end = (uint8_t *) buffer + size;
+
+  if (size == 0)
+    return;
+  for (; upage < end; upage += PGSIZE)
+    page_unlock (upage);
 }
+#endif
 
-static inline void
-get_user_strings (char **args, int flag)
+static inline char *
+get_user_string_l (const char *str, unsigned size)
 {
-  ASSERT (0 <= flag && flag <= 0b1111);
-  check_single_user_string (args, flag, 0);
-  check_single_user_string (args, flag, 1);
-  check_single_user_string (args, flag, 2);
-  check_single_user_string (args, flag, 3);
-  get_single_user_string (args, flag, 0);
-  get_single_user_string (args, flag, 1);
-  get_single_user_string (args, flag, 2);
-  get_single_user_string (args, flag, 3);
+  char *buffer = 0;
+  buffer = malloc (size);
+  if (!buffer)
+    return 0;
+  if (!copy_in (buffer, str, size))
+    {
+      free (buffer);
+      return 0;
+    }
+  return buffer;
+}
+
+static inline char *
+get_user_string (const char *str)
+{
+  size_t len;
+  if (!user_strlen (str, &len))
+    return 0;
+  return get_user_string_l (str, len + 1);
 }
 
 
@@ -217,11 +463,7 @@ remove (const char *file)
 static int
 open (const char *file)
 {
-  int result = -1;
-  lock_acquire (&file_lock);
-  result = process_add_file (filesys_open (file));
-  lock_release (&file_lock);
-  return result;
+  return process_add_file (filesys_open (file));
 }
 
 static int
@@ -237,45 +479,292 @@ static int
 read (int fd, void *buffer, unsigned size)
 {
   struct file *f;
-  lock_acquire (&file_lock);
 
   if (fd == STDIN_FILENO)
   {
     unsigned count = size;
+    lock_acquire (&stdin_lock);
     while (count--)
-      *((char *)buffer++) = input_getc();
-    lock_release (&file_lock);
+      if (!put_user (buffer++, input_getc ()))
+        {
+          lock_release (&stdin_lock);
+          exit (-1);
+        }
+    lock_release (&stdin_lock);
     return size;
   }
   if ((f = process_get_file (fd)) == NULL)
+    return -1;
+  return file_read (f, buffer, size);
+}
+
+/* Writes the SIZE bytes at user address BUFFER to F, or to the
+   console if F is null, straight from the user's pages instead
+   of copying the whole buffer into the kernel first.  A file is
+   written at offset OFS, or at its current position if OFS is
+   negative.  Returns the number of bytes written.
+
+   Under VM, every page of the buffer is locked into memory
+   before anything is written, so that the whole buffer goes out
+   in a single file system write, or under a single hold of the
+   console lock, and no other write can land in the middle. */
+static int
+write_user (struct file *f, const void *buffer, unsigned size, off_t ofs)
+{
+  struct iovec iov;
+  int written;
+
+  iov.iov_base = (void *) buffer;
+  iov.iov_len = size;
+  if (!pin_iovec (&iov, 1, false))
+    exit (-1);
+
+  if (f == NULL)
     {
-      lock_release (&file_lock);
-      return -1;
+      putbuf (buffer, size);
+      written = size;
     }
-  size = file_read (f, buffer, size);
-  lock_release (&file_lock);
-  return size;
+  else if (ofs < 0)
+    written = file_writev (f, &iov, 1);
+  else
+    written = file_write_at (f, buffer, size, ofs);
+
+#ifdef VM
+  unpin_iovec (&iov, 1);
+#endif
+  return written;
 }
 
+/* Writes the SIZE bytes at user address BUFFER to FD at its
+   current position, advancing it.  Returns the number of bytes
+   written. */
 static int
 write (int fd, const void *buffer, unsigned size)
 {
-  struct file *f;
-  lock_acquire (&file_lock);
-  if (fd == STDOUT_FILENO)
+  struct file *f = NULL;
+
+  if (fd != STDOUT_FILENO && (f = process_get_file (fd)) == NULL)
+    return 0;
+  return write_user (f, buffer, size, -1);
+}
+
+/* Reads SIZE bytes from file FD into BUFFER, starting at offset
+   OFS, without using or changing FD's position, so that several
+   threads can read one open file at once.  Returns the number of
+   bytes read, or -1 if FD is not an open file or OFS is
+   negative. */
+static int
+pread (int fd, void *buffer, unsigned size, int32_t ofs)
+{
+  struct file *f = process_get_file (fd);
+
+  if (f == NULL || ofs < 0)
+    return -1;
+  return file_read_at (f, buffer, size, ofs);
+}
+
+/* Writes SIZE bytes from BUFFER to file FD, starting at offset
+   OFS, without using or changing FD's position.  Returns the
+   number of bytes written, or -1 if FD is not an open file or
+   OFS is negative. */
+static int
+pwrite (int fd, const void *buffer, unsigned size, int32_t ofs)
+{
+  struct file *f = process_get_file (fd);
+
+  if (f == NULL || ofs < 0)
+    return -1;
+  return write_user (f, buffer, size, ofs);
+}
+
+/* Copies the CNT-element iovec array at user address UIOV into
+   IOV and checks that each buffer lies in user memory.  Returns
+   the buffers' total length, or -1 if CNT is out of range or
+   the total does not fit in an int. */
+static int
+get_iovec (struct iovec *iov, const struct iovec *uiov, int cnt)
+{
+  size_t total = 0;
+  int i;
+
+  if (cnt < 0 || cnt > IOV_MAX)
+    return -1;
+  check_user_string_l ((const char *) uiov, cnt * sizeof *uiov);
+  if (!copy_in (iov, uiov, cnt * sizeof *uiov))
+    exit (-1);
+
+  for (i = 0; i < cnt; i++)
     {
-      putbuf (buffer, size);
-      lock_release (&file_lock);
-      return size;  
+      check_user_string_l (iov[i].iov_base, iov[i].iov_len);
+      if (iov[i].iov_len > (size_t) INT32_MAX - total)
+        return -1;
+      total += iov[i].iov_len;
     }
-  if ((f = process_get_file (fd)) == NULL)
+  return total;
+}
+
+#ifdef VM
+/* Returns true if user page UPAGE overlaps one of the first CNT
+   buffers in IOV. */
+static bool
+iovec_has_page (const struct iovec *iov, int cnt, const uint8_t *upage)
+{
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    if (iov[i].iov_len > 0
+        && upage >= (uint8_t *) pg_round_down (iov[i].iov_base)
+        && upage < (uint8_t *) iov[i].iov_base + iov[i].iov_len)
+      return true;
+  return false;
+}
+
+/* Unlocks the pages from START up to END of buffer I in IOV,
+   skipping any that also belong to an earlier buffer. */
+static void
+unpin_iovec_range (const struct iovec *iov, int i,
+                   const uint8_t *start, const uint8_t *end)
+{
+  const uint8_t *upage;
+
+  for (upage = start; upage < end; upage += PGSIZE)
+    if (!iovec_has_page (iov, i, upage))
+      page_unlock (upage);
+}
+
+/* Unlocks the pages of the first CNT buffers in IOV. */
+static void
+unpin_iovec (const struct iovec *iov, int cnt)
+{
+  int i;
+
+  for (i = 0; i < cnt; i++)
+    if (iov[i].iov_len > 0)
+      unpin_iovec_range (iov, i, pg_round_down (iov[i].iov_base),
+                         (uint8_t *) iov[i].iov_base + iov[i].iov_len);
+}
+#endif
+
+/* Makes the CNT buffers in IOV safe for the file system to
+   access directly, as pin_user_buffer() or check_user_buffer()
+   does for a single buffer.  A page shared by several buffers
+   is locked only once, and empty buffers are skipped.  If WRITE
+   is true, the buffers must be writable.  Returns false, with
+   nothing locked, if a buffer is not mapped suitably. */
+static bool
+pin_iovec (const struct iovec *iov, int cnt, bool write)
+{
+  int i;
+
+  for (i = 0; i < cnt; i++)
     {
-      lock_release (&file_lock);
-      return 0;
+#ifdef VM
+      const uint8_t *start = pg_round_down (iov[i].iov_base);
+      const uint8_t *end = (uint8_t *) iov[i].iov_base + iov[i].iov_len;
+      const uint8_t *upage;
+
+      if (iov[i].iov_len == 0)
+        continue;
+      for (upage = start; upage < end; upage += PGSIZE)
+        if (!iovec_has_page (iov, i, upage)
+            && !pin_user_page (upage, write))
+          {
+            unpin_iovec (iov, i);
+            unpin_iovec_range (iov, i, start, upage);
+            return false;
+          }
+#else
+      if (iov[i].iov_len > 0
+          && !check_user_buffer (iov[i].iov_base, iov[i].iov_len, write))
+        return false;
+#endif
     }
-  size = file_write (f, buffer, size);
-  lock_release (&file_lock);
-  return size;
+  return true;
+}
+
+/* Reads from FD into the CNT buffers described by the iovec
+   array at user address UIOV, in order, as one read.  Returns
+   the number of bytes read, or -1 if FD or the array is bad. */
+static int
+readv (int fd, const struct iovec *uiov, int cnt)
+{
+  struct iovec iov[IOV_MAX];
+  struct file *f = NULL;
+  int result = 0;
+
+  if (get_iovec (iov, uiov, cnt) < 0
+      || (fd != STDIN_FILENO && (f = process_get_file (fd)) == NULL))
+    return -1;
+  if (!pin_iovec (iov, cnt, true))
+    exit (-1);
+
+  if (f == NULL)
+    {
+      int i;
+      for (i = 0; i < cnt; i++)
+        result += read (STDIN_FILENO, iov[i].iov_base, iov[i].iov_len);
+    }
+  else
+    result = file_readv (f, iov, cnt);
+
+#ifdef VM
+  unpin_iovec (iov, cnt);
+#endif
+  return result;
+}
+
+/* Writes the CNT buffers described by the iovec array at user
+   address UIOV, in order, to FD as one write: a file's lock is
+   taken once for the lot, so that no other write can come in
+   between.  Returns the number of bytes written, or -1 if FD or
+   the array is bad. */
+static int
+writev (int fd, const struct iovec *uiov, int cnt)
+{
+  struct iovec iov[IOV_MAX];
+  struct file *f = NULL;
+  int result = 0;
+
+  if (get_iovec (iov, uiov, cnt) < 0
+      || (fd != STDOUT_FILENO && (f = process_get_file (fd)) == NULL))
+    return -1;
+  if (!pin_iovec (iov, cnt, false))
+    exit (-1);
+
+  if (f == NULL)
+    {
+      int i;
+      for (i = 0; i < cnt; i++)
+        {
+          putbuf (iov[i].iov_base, iov[i].iov_len);
+          result += iov[i].iov_len;
+        }
+    }
+  else
+    result = file_writev (f, iov, cnt);
+
+#ifdef VM
+  unpin_iovec (iov, cnt);
+#endif
+  return result;
+}
+
+/* Copies SIZE bytes from file FD_IN, starting at its position,
+   to file FD_OUT, starting at its position, without passing the
+   data through user memory, and advances both positions.
+   Returns the number of bytes copied, or -1 if either FD is not
+   an open file. */
+static int
+copy_file_range (int fd_in, int fd_out, unsigned size)
+{
+  struct file *in = process_get_file (fd_in);
+  struct file *out = process_get_file (fd_out);
+
+  if (in == NULL || out == NULL)
+    return -1;
+  if (size > INT32_MAX)
+    size = INT32_MAX;
+  return file_copy (out, in, size);
 }
 
 static void
@@ -302,80 +791,415 @@ close (int fd)
   process_close_file (fd);
 }
 
+#ifdef VM
+static int
+mmap (int fd, void *addr)
+{
+  struct file *f = process_get_file (fd);
+
+  if (f == NULL)
+    return -1;
+  return mmap_map (f, addr);
+}
+
+static void
+munmap (int mapid)
+{
+  mmap_unmap (mapid);
+}
+#endif
+
+static bool
+memstat (enum memstat_pool pool, struct palloc_stats *buffer)
+{
+  struct palloc_stats stats;
+  if (!palloc_get_stats (pool, &stats))
+    return false;
+  if (!copy_out (buffer, &stats, sizeof stats))
+    exit (-1);
+  return true;
+}
+
+static bool
+memusage (struct proc_memstat *buffer)
+{
+  struct proc_memstat stats = thread_current ()->mem;
+  if (!copy_out (buffer, &stats, sizeof stats))
+    exit (-1);
+  return true;
+}
+
+#ifdef VM
+static bool
+wsstat (struct proc_wsstat *buffer)
+{
+  struct proc_wsstat stats;
+  if (!wset_get (&stats))
+    return false;
+  if (!copy_out (buffer, &stats, sizeof stats))
+    exit (-1);
+  return true;
+}
+#endif
+
+
+static int32_t
+sys_halt (int32_t *args UNUSED, struct intr_frame *f UNUSED)
+{
+  halt ();
+  NOT_REACHED ();
+}
+
+static int32_t
+sys_exit (int32_t *args, struct intr_frame *f UNUSED)
+{
+  exit (args[0]);
+  NOT_REACHED ();
+}
+
+static int32_t
+sys_exec (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return exec ((const char *) args[0]);
+}
+
+static int32_t
+sys_wait (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return wait ((tid_t) args[0]);
+}
+
+static int32_t
+sys_create (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return create ((const char *) args[0], args[1]);
+}
+
+static int32_t
+sys_remove (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return remove ((const char *) args[0]);
+}
+
+static int32_t
+sys_open (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return open ((const char *) args[0]);
+}
+
+static int32_t
+sys_filesize (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return filesize ((int) args[0]);
+}
+
+static int32_t
+sys_read (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return read ((int) args[0], (void *) args[1], (unsigned) args[2]);
+}
+
+static int32_t
+sys_write (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return write ((int) args[0], (const void *) args[1], (unsigned) args[2]);
+}
+
+static int32_t
+sys_seek (int32_t *args, struct intr_frame *f UNUSED)
+{
+  seek ((int) args[0], (unsigned) args[1]);
+  return 0;
+}
+
+static int32_t
+sys_tell (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return tell ((int) args[0]);
+}
+
+static int32_t
+sys_close (int32_t *args, struct intr_frame *f UNUSED)
+{
+  close ((int) args[0]);
+  return 0;
+}
+
+static int32_t
+sys_readv (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return readv ((int) args[0], (const struct iovec *) args[1],
+                (int) args[2]);
+}
+
+static int32_t
+sys_writev (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return writev ((int) args[0], (const struct iovec *) args[1],
+                 (int) args[2]);
+}
+
+static int32_t
+sys_pread (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return pread ((int) args[0], (void *) args[1], (unsigned) args[2],
+                args[3]);
+}
+
+static int32_t
+sys_pwrite (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return pwrite ((int) args[0], (const void *) args[1], (unsigned) args[2],
+                 args[3]);
+}
+
+static int32_t
+sys_ring_enter (int32_t *args, struct intr_frame *f)
+{
+  return ring_enter ((struct ring *) args[0], f);
+}
+
+static int32_t
+sys_copy_file_range (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return copy_file_range ((int) args[0], (int) args[1], (unsigned) args[2]);
+}
+
+#ifdef VM
+static int32_t
+sys_mmap (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return mmap ((int) args[0], (void *) args[1]);
+}
+
+static int32_t
+sys_munmap (int32_t *args, struct intr_frame *f UNUSED)
+{
+  munmap ((int) args[0]);
+  return 0;
+}
+
+static int32_t
+sys_fork (int32_t *args UNUSED, struct intr_frame *f)
+{
+  return process_fork (f);
+}
+
+static int32_t
+sys_wsstat (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return wsstat ((struct proc_wsstat *) args[0]);
+}
+#endif
+
+static int32_t
+sys_memstat (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return memstat ((enum memstat_pool) args[0],
+                  (struct palloc_stats *) args[1]);
+}
+
+static int32_t
+sys_memusage (int32_t *args, struct intr_frame *f UNUSED)
+{
+  return memusage ((struct proc_memstat *) args[0]);
+}
+
+static int32_t
+sys_memlimit (int32_t *args, struct intr_frame *f UNUSED)
+{
+  memacct_set_child_limit ((unsigned) args[0]);
+  return 0;
+}
+
+/* Returns the length of buffer argument ARG_IDX of SC, given
+   argument values ARGS. */
+static unsigned
+arg_length (const struct syscall *sc, const int32_t *args, int arg_idx)
+{
+  const struct syscall_arg *a = &sc->args[arg_idx];
+  return a->len_arg >= 0 ? (unsigned) args[a->len_arg] : a->size;
+}
+
+/* Releases what get_args() acquired for the first ARG_CNT of
+   system call SC's arguments ARGS: frees the kernel copies of
+   strings and unlocks pinned buffers. */
+static void
+release_args (const struct syscall *sc, int32_t *args, int arg_cnt)
+{
+  int i;
+
+  for (i = 0; i < arg_cnt; i++)
+    if (sc->args[i].kind == ARG_STRING)
+      free ((char *) args[i]);
+#ifdef VM
+    else if (sc->args[i].kind == ARG_PINNED)
+      unpin_user_buffer ((void *) args[i], arg_length (sc, args, i));
+#endif
+}
+
+/* Validates system call SC's arguments ARGS as SC's table entry
+   describes.  Buffers are checked to lie in user memory, and
+   pinned ones are locked into memory; strings are copied into
+   the kernel, replacing the user pointers in ARGS.  Kills the
+   process, releasing whatever it has acquired, if an argument is
+   bad. */
+static void
+get_args (const struct syscall *sc, int32_t *args)
+{
+  int i;
+
+  /* Check buffers first: that takes nothing that must be given
+     back. */
+  for (i = 0; i < sc->arg_cnt; i++)
+    if (sc->args[i].kind == ARG_BUFFER || sc->args[i].kind == ARG_PINNED)
+      check_user_string_l ((const char *) args[i],
+                           arg_length (sc, args, i));
+
+  for (i = 0; i < sc->arg_cnt; i++)
+    {
+      bool ok = true;
+
+      if (sc->args[i].kind == ARG_STRING)
+        {
+          char *copy = get_user_string ((const char *) args[i]);
+          ok = copy != NULL;
+          if (ok)
+            args[i] = (int32_t) copy;
+        }
+      else if (sc->args[i].kind == ARG_PINNED)
+        {
+#ifdef VM
+          ok = pin_user_buffer ((void *) args[i], arg_length (sc, args, i));
+#else
+          ok = check_user_buffer ((void *) args[i],
+                                  arg_length (sc, args, i), true);
+#endif
+        }
+
+      if (!ok)
+        {
+          release_args (sc, args, i);
+          exit (-1);
+        }
+    }
+}
+
+/* Validates ARGS, calls SC with them on behalf of the process
+   interrupted at F, releases them, and returns the result. */
+static int32_t
+run_syscall (struct syscall *sc, int32_t *args, struct intr_frame *f)
+{
+  enum intr_level old_level;
+  int64_t start;
+  int32_t result;
+
+  get_args (sc, args);
+  start = timer_ticks ();
+  old_level = intr_disable ();
+  sc->call_cnt++;
+  intr_set_level (old_level);
+
+  result = sc->func (args, f);
+
+  old_level = intr_disable ();
+  sc->ticks += timer_elapsed (start);
+  intr_set_level (old_level);
+  release_args (sc, args, sc->arg_cnt);
+  return result;
+}
 
 static void
-syscall_handler (struct intr_frame *f UNUSED) 
+syscall_handler (struct intr_frame *f) 
 {
-  int32_t args[4];
-  check_address4 (f->esp);
+  int32_t args[SYSCALL_ARG_MAX];
+  struct syscall *sc;
+  int32_t nr;
+
+#ifdef VM
+  thread_current ()->user_esp = f->esp;
+#endif
+  check_user_string_l (f->esp, sizeof nr);
+  if (!copy_in (&nr, f->esp, sizeof nr))
+    exit (-1);
+  if (nr < 0 || (size_t) nr >= SYSCALL_CNT || syscalls[nr].func == NULL)
+    exit (-1);
+  sc = &syscalls[nr];
 
-  switch (*(int *) f->esp)
+  check_user_string_l ((const char *) f->esp + 4, sc->arg_cnt * 4);
+  if (!copy_in (args, (const uint8_t *) f->esp + 4, sc->arg_cnt * 4))
+    exit (-1);
+  f->eax = run_syscall (sc, args, f);
+}
+
+/* Carries out the system calls submitted to RING, in order,
+   posting each one's result, until the submission queue is empty
+   or the completion queue is full.  A call that may not be
+   submitted through a ring completes with -1.  F is the frame of
+   the ring_enter() call, on whose behalf the calls run.  Returns
+   the number of calls carried out, or -1 if RING's indexes are
+   inconsistent.
+
+   Each call's ticks are counted against that call, so they are
+   taken back out of ring_enter()'s own count, which is left with
+   just the cost of running the ring. */
+static int
+ring_enter (struct ring *ring, struct intr_frame *f)
+{
+  uint32_t sq_head, sq_tail, cq_head, cq_tail;
+  enum intr_level old_level;
+  int64_t nested_ticks = 0;
+  int done;
+
+  if (!copy_in (&sq_head, &ring->sq_head, sizeof sq_head)
+      || !copy_in (&sq_tail, &ring->sq_tail, sizeof sq_tail)
+      || !copy_in (&cq_head, &ring->cq_head, sizeof cq_head)
+      || !copy_in (&cq_tail, &ring->cq_tail, sizeof cq_tail))
+    exit (-1);
+  if (sq_tail - sq_head > RING_ENTRIES || cq_tail - cq_head > RING_ENTRIES)
+    return -1;
+
+  for (done = 0; sq_head != sq_tail && cq_tail - cq_head < RING_ENTRIES;
+       done++)
     {
-      case SYS_HALT:
-        halt ();
-        break;
-      case SYS_EXIT:
-        get_arguments (f->esp, args, 1);
-        exit (args[0]);
-        break;
-      case SYS_CREATE:
-        get_arguments (f->esp, args, 2);
-        get_user_strings ((char **) args, 0b1000);
-        f->eax = create ((const char *) args[0], args[1]);
-        free_user_strings ((char **) args, 0b1000);
-        break;
-      case SYS_REMOVE:
-        get_arguments (f->esp, args, 1);
-        get_user_strings ((char **) args, 0b1000);
-        f->eax = remove ((const char *) args[0]);
-        free_user_strings ((char **) args, 0b1000); 
-        break;
-      case SYS_WRITE:
-        get_arguments (f->esp, args, 3);
-        check_user_string_l ((const char *) args[1], (unsigned) args[2]);
-        args[1] = (int) get_user_string_l ((const char *) args[1], (unsigned) args[2]);
-        f->eax = write ((int) args[0], (const void *) args[1], (unsigned) args[2]);
-        free ((void *) args[1]);
-        args[1] = 0;
-        break;
-      case SYS_EXEC:
-        get_arguments (f->esp, args, 1);
-        get_user_strings ((char **) args, 0b1000);
-        f->eax = exec ((const char *) args[0]);
-        free_user_strings ((char **) args, 0b1000);
-        break;
-      case SYS_WAIT:
-        get_arguments (f->esp, args, 1);
-        f->eax = wait ((tid_t) args[0]);
-        break;
-      case SYS_OPEN:
-        get_arguments (f->esp, args, 1);
-        get_user_strings ((char **) args, 0b1000);
-        f->eax = open ((const char *) args[0]);
-        free_user_strings ((char **) args, 0b1000);
-        break;
-      case SYS_FILESIZE:
-        get_arguments (f->esp, args, 1);
-        f->eax = filesize ((int) args[0]);
-        break;
-      case SYS_READ:
-        get_arguments (f->esp, args, 3);
-        check_user_string_l ((const char *) args[1], (unsigned) args[2]);
-        f->eax = read ((int) args[0], (void *) args[1], (unsigned) args[2]);
-        break;
-      case SYS_SEEK:
-        get_arguments (f->esp, args, 2);
-        seek ((int) args[0], (unsigned) args[1]);
-        break;
-      case SYS_TELL:
-        get_arguments (f->esp, args, 1);
-        f->eax = tell ((int) args[0]);
-        break;
-      case SYS_CLOSE:
-        get_arguments (f->esp, args, 1);
-        close ((int) args[0]);
-        break;
-      default:
-        exit(-1);
+      struct ring_sqe sqe;
+      struct ring_cqe cqe;
+
+      if (!copy_in (&sqe, &ring->sq[sq_head++ % RING_ENTRIES], sizeof sqe))
+        exit (-1);
+      if (sqe.number >= 0 && (size_t) sqe.number < SYSCALL_CNT
+          && syscalls[sqe.number].batchable)
+        {
+          int64_t start = timer_ticks ();
+          cqe.result = run_syscall (&syscalls[sqe.number], sqe.args, f);
+          nested_ticks += timer_elapsed (start);
+        }
+      else
+        cqe.result = -1;
+      cqe.user_data = sqe.user_data;
+      if (!copy_out (&ring->cq[cq_tail++ % RING_ENTRIES], &cqe, sizeof cqe))
+        exit (-1);
     }
+
+  if (!copy_out (&ring->sq_head, &sq_head, sizeof sq_head)
+      || !copy_out (&ring->cq_tail, &cq_tail, sizeof cq_tail))
+    exit (-1);
+
+  old_level = intr_disable ();
+  syscalls[SYS_RING_ENTER].ticks -= nested_ticks;
+  intr_set_level (old_level);
+  return done;
+}
+
+/* Prints the number of calls of, and ticks spent in, each
+   system call that was used. */
+void
+syscall_print_stats (void)
+{
+  size_t i;
+
+  for (i = 0; i < SYSCALL_CNT; i++)
+    if (syscalls[i].call_cnt > 0)
+      printf ("Syscall: %-8s %8llu calls, %6lld ticks\n", syscalls[i].name,
+              syscalls[i].call_cnt, syscalls[i].ticks);
 }
@@ -2,5 +2,9 @@
 #define USERPROG_SYSCALL_H
 
 void syscall_init (void);
+void syscall_print_stats (void);
+
+/* Bounds of the code that may fault on a user address. */
+extern const char user_access_begin[], user_access_end[];
 
 #endif /* userprog/syscall.h */
@@ -0,0 +1,269 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/memacct.h"
+#include "vm/page.h"
+
+/* Frame table. */
+static struct frame *frames;
+static size_t frame_cnt;
+
+/* Entries with no frame behind them. */
+static struct list free_frames;
+
+/* Protects FREE_FRAMES and HAND. */
+static struct lock scan_lock;
+
+/* Clock hand for eviction. */
+static size_t hand;
+
+/* A frame of zeros, mapped read-only for every all-zero page
+   until the page is first written.  It comes from the kernel
+   pool, is not in the frame table and is never evicted or
+   freed. */
+static struct frame zero_frame;
+
+static bool frame_accessed_recently (struct frame *);
+static bool frame_owned_by (struct frame *, struct thread *);
+
+/* Initializes the frame table with one entry for each page in
+   the user pool. */
+void
+frame_init (void)
+{
+  struct palloc_stats stats;
+  size_t i;
+
+  lock_init (&scan_lock);
+  list_init (&free_frames);
+
+  palloc_get_stats (MEMSTAT_USER, &stats);
+  frame_cnt = stats.page_cnt;
+  frames = calloc (frame_cnt, sizeof *frames);
+  if (frames == NULL && frame_cnt > 0)
+    PANIC ("out of memory allocating frame table");
+
+  for (i = 0; i < frame_cnt; i++)
+    {
+      lock_init (&frames[i].lock);
+      list_init (&frames[i].pages);
+      list_push_back (&free_frames, &frames[i].free_elem);
+    }
+
+  lock_init (&zero_frame.lock);
+  list_init (&zero_frame.pages);
+  zero_frame.kpage = palloc_get_page (PAL_ZERO);
+  if (zero_frame.kpage == NULL)
+    PANIC ("out of memory allocating zero frame");
+}
+
+/* Tries to allocate and lock a frame for PAGE, evicting a page
+   with the clock algorithm if the user pool is exhausted.  Pages
+   whose accessed bit is set get a second chance: the bit is
+   cleared and the hand moves on.  If PAGE's process is at its
+   resident limit, only a frame that belongs to that process
+   alone may be taken, even if free frames remain, so that one
+   process cannot push out everybody else's pages.  If ZERO is
+   true, the frame is zeroed.  Returns the frame, or a null
+   pointer if every candidate frame is locked or eviction
+   fails. */
+static struct frame *
+try_frame_alloc_and_lock (struct page *page, bool zero)
+{
+  bool local = memacct_user_full (page->thread);
+  struct frame *f;
+  size_t i;
+
+  lock_acquire (&scan_lock);
+
+  /* Take a fresh page from the user pool if there is one. */
+  if (!local && !list_empty (&free_frames))
+    {
+      void *kpage = palloc_get_page (PAL_USER | (zero ? PAL_ZERO : 0));
+      if (kpage != NULL)
+        {
+          f = list_entry (list_pop_front (&free_frames),
+                          struct frame, free_elem);
+          lock_acquire (&f->lock);
+          f->kpage = kpage;
+          list_push_back (&f->pages, &page->frame_elem);
+          lock_release (&scan_lock);
+          return f;
+        }
+    }
+
+  /* None left.  Find a frame to evict.  Two sweeps are enough
+     for every unlocked frame to lose its second chance. */
+  for (i = 0; i < frame_cnt * 2; i++)
+    {
+      f = &frames[hand];
+      if (++hand >= frame_cnt)
+        hand = 0;
+
+      if (f->kpage == NULL || !lock_try_acquire (&f->lock))
+        continue;
+      if (f->kpage == NULL
+          || (local && !frame_owned_by (f, page->thread))
+          || frame_accessed_recently (f))
+        {
+          lock_release (&f->lock);
+          continue;
+        }
+
+      /* Evict without holding the scan lock, so that other
+         threads can allocate while we wait for the disk. */
+      lock_release (&scan_lock);
+      if (!page_out (f))
+        {
+          lock_release (&f->lock);
+          return NULL;
+        }
+      list_push_back (&f->pages, &page->frame_elem);
+      if (zero)
+        memset (f->kpage, 0, PGSIZE);
+      if (local)
+        memacct_reclaimed (page->thread);
+      return f;
+    }
+
+  lock_release (&scan_lock);
+  return NULL;
+}
+
+/* Allocates a frame for PAGE and returns it locked, zeroed if
+   ZERO is true.  Returns a null pointer if no frame can be
+   freed up. */
+struct frame *
+frame_alloc_and_lock (struct page *page, bool zero)
+{
+  int try;
+
+  for (try = 0; try < 3; try++)
+    {
+      struct frame *f = try_frame_alloc_and_lock (page, zero);
+      if (f != NULL)
+        {
+          ASSERT (lock_held_by_current_thread (&f->lock));
+          return f;
+        }
+
+      /* Every frame is locked.  Give their holders a moment. */
+      timer_msleep (100);
+    }
+  return NULL;
+}
+
+/* Locks the zero frame and adds PAGE to the pages mapped to it.
+   Returns the zero frame. */
+struct frame *
+frame_zero_lock (struct page *page)
+{
+  lock_acquire (&zero_frame.lock);
+  list_push_back (&zero_frame.pages, &page->frame_elem);
+  return &zero_frame;
+}
+
+/* Returns true if F is the zero frame.  Its contents must never
+   change. */
+bool
+frame_is_zero (const struct frame *f)
+{
+  return f == &zero_frame;
+}
+
+/* Returns true if any page mapped to locked frame F has been
+   accessed since the last call, clearing their accessed bits. */
+static bool
+frame_accessed_recently (struct frame *f)
+{
+  struct list_elem *e;
+  bool accessed = false;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    if (page_accessed_recently (list_entry (e, struct page, frame_elem)))
+      accessed = true;
+  return accessed;
+}
+
+/* Returns true if every page mapped to locked frame F belongs
+   to thread T. */
+static bool
+frame_owned_by (struct frame *f, struct thread *t)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    if (list_entry (e, struct page, frame_elem)->thread != t)
+      return false;
+  return true;
+}
+
+/* Locks PAGE's frame into memory, if it has one.  If the frame
+   is being evicted, waits for that to finish; PAGE then has no
+   frame. */
+void
+frame_lock (struct page *p)
+{
+  struct frame *f = p->frame;
+  if (f != NULL)
+    {
+      lock_acquire (&f->lock);
+      if (f != p->frame)
+        {
+          lock_release (&f->lock);
+          ASSERT (p->frame == NULL);
+        }
+    }
+}
+
+/* Tries to lock PAGE's frame without waiting.  Returns true if
+   successful, false if PAGE has no frame or its frame is already
+   locked. */
+bool
+frame_try_lock (struct page *p)
+{
+  struct frame *f = p->frame;
+
+  if (f == NULL || !lock_try_acquire (&f->lock))
+    return false;
+  if (f != p->frame)
+    {
+      lock_release (&f->lock);
+      return false;
+    }
+  return true;
+}
+
+/* Unlocks frame F, allowing it to be evicted. */
+void
+frame_unlock (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&f->lock));
+  lock_release (&f->lock);
+}
+
+/* Returns locked frame F, to which no page may be mapped any
+   longer, to the user pool. */
+void
+frame_free (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&f->lock));
+  ASSERT (list_empty (&f->pages));
+  ASSERT (!frame_is_zero (f));
+
+  palloc_free_page (f->kpage);
+  f->kpage = NULL;
+
+  lock_acquire (&scan_lock);
+  list_push_back (&free_frames, &f->free_elem);
+  lock_release (&scan_lock);
+  lock_release (&f->lock);
+}
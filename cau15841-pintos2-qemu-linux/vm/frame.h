@@ -0,0 +1,42 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <list.h>
+#include <stdbool.h>
+#include "threads/synch.h"
+
+struct page;
+
+/* A physical frame from the user pool.
+
+   The frame table has one entry for every page in the user
+   pool, whether or not it is allocated.  An entry's lock is held
+   while the frame is being filled, while the kernel needs it to
+   stay put (for example, while a system call copies into it),
+   and while it is being evicted.
+
+   Usually a frame holds one process's page, but a page of a
+   mapped file is shared by every process that maps it, and
+   fork() shares a process's pages with its child until one of
+   them writes, and every all-zero page that has only been read
+   shares a single zero frame, so each frame keeps a list of the
+   pages mapped to it. */
+struct frame
+  {
+    struct lock lock;           /* Prevents simultaneous access. */
+    void *kpage;                /* Kernel virtual address, or null. */
+    struct list pages;          /* Pages mapped to this frame. */
+    struct list_elem free_elem; /* Element in free entry list. */
+  };
+
+void frame_init (void);
+
+struct frame *frame_alloc_and_lock (struct page *, bool zero);
+struct frame *frame_zero_lock (struct page *);
+bool frame_is_zero (const struct frame *);
+void frame_lock (struct page *);
+bool frame_try_lock (struct page *);
+void frame_unlock (struct frame *);
+void frame_free (struct frame *);
+
+#endif /* vm/frame.h */
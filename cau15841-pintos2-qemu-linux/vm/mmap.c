@@ -0,0 +1,178 @@
+#include "vm/mmap.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/page.h"
+
+/* A memory-mapped file. */
+struct mapping
+  {
+    struct list_elem elem;      /* Element in thread's mapping list. */
+    int id;                     /* Mapping identifier. */
+    struct file *file;          /* Private handle on the file. */
+    uint8_t *base;              /* First mapped page. */
+    size_t page_cnt;            /* Number of mapped pages. */
+    struct fault_stream stream; /* Sequential fault state. */
+  };
+
+static struct mapping *lookup_mapping (int mapid);
+static void unmap (struct mapping *);
+
+/* Maps FILE into the current process's address space starting at
+   ADDR, which must be page-aligned.  The pages are read from the
+   file when first touched and written back, if modified, when
+   they are unmapped.  Returns the new mapping's identifier, or
+   -1 if FILE is empty, if the range would overlap pages already
+   in use, or if memory allocation fails. */
+int
+mmap_map (struct file *file, void *addr)
+{
+  struct thread *t = thread_current ();
+  struct mapping *m;
+  off_t length;
+  size_t page_cnt, i;
+
+  if (file == NULL || addr == NULL || pg_ofs (addr) != 0)
+    return -1;
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return -1;
+  m->file = file_reopen (file);
+  length = m->file != NULL ? file_length (m->file) : 0;
+  if (length == 0)
+    {
+      file_close (m->file);
+      free (m);
+      return -1;
+    }
+  m->base = addr;
+  m->page_cnt = 0;
+  page_init_stream (&m->stream);
+
+  page_cnt = DIV_ROUND_UP (length, PGSIZE);
+  for (i = 0; i < page_cnt; i++)
+    {
+      uint8_t *upage = m->base + i * PGSIZE;
+      if (!is_user_vaddr (upage)
+          || !page_add_mmap (upage, file_get_inode (m->file), i * PGSIZE,
+                             &m->stream))
+        {
+          unmap (m);
+          return -1;
+        }
+      m->page_cnt++;
+    }
+
+  m->id = t->next_mapid++;
+  list_push_back (&t->mappings, &m->elem);
+  return m->id;
+}
+
+/* Unmaps the current process's mapping MAPID, if it exists. */
+void
+mmap_unmap (int mapid)
+{
+  struct mapping *m = lookup_mapping (mapid);
+
+  if (m != NULL)
+    {
+      list_remove (&m->elem);
+      unmap (m);
+    }
+}
+
+/* Unmaps all of the current process's mappings. */
+void
+mmap_unmap_all (void)
+{
+  struct thread *t = thread_current ();
+
+  while (!list_empty (&t->mappings))
+    {
+      struct list_elem *e = list_pop_front (&t->mappings);
+      unmap (list_entry (e, struct mapping, elem));
+    }
+}
+
+/* Gives the current process, which PARENT is forking, the same
+   mappings as PARENT, with the same identifiers.  Pages of
+   mapped files stay shared between the two.  Returns true if
+   successful, false if memory allocation fails. */
+bool
+mmap_copy (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&parent->mappings); e != list_end (&parent->mappings);
+       e = list_next (e))
+    {
+      struct mapping *pm = list_entry (e, struct mapping, elem);
+      struct mapping *m;
+      size_t i;
+
+      m = malloc (sizeof *m);
+      if (m == NULL)
+        return false;
+      m->file = file_reopen (pm->file);
+      if (m->file == NULL)
+        {
+          free (m);
+          return false;
+        }
+      m->id = pm->id;
+      m->base = pm->base;
+      m->page_cnt = 0;
+      page_init_stream (&m->stream);
+      for (i = 0; i < pm->page_cnt; i++)
+        {
+          if (!page_add_mmap (m->base + i * PGSIZE,
+                              file_get_inode (m->file), i * PGSIZE,
+                              &m->stream))
+            {
+              unmap (m);
+              return false;
+            }
+          m->page_cnt++;
+        }
+      list_push_back (&t->mappings, &m->elem);
+    }
+  t->next_mapid = parent->next_mapid;
+  return true;
+}
+
+/* Returns the current process's mapping MAPID, or a null
+   pointer if there is none. */
+static struct mapping *
+lookup_mapping (int mapid)
+{
+  struct thread *t = thread_current ();
+  struct list_elem *e;
+
+  for (e = list_begin (&t->mappings); e != list_end (&t->mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if (m->id == mapid)
+        return m;
+    }
+  return NULL;
+}
+
+/* Removes M's pages, writing back those that were modified,
+   closes its file and frees it. */
+static void
+unmap (struct mapping *m)
+{
+  size_t i;
+
+  for (i = 0; i < m->page_cnt; i++)
+    page_remove (m->base + i * PGSIZE);
+  file_close (m->file);
+  free (m);
+}
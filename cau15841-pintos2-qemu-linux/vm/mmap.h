@@ -0,0 +1,14 @@
+#ifndef VM_MMAP_H
+#define VM_MMAP_H
+
+#include <stdbool.h>
+
+struct file;
+struct thread;
+
+int mmap_map (struct file *, void *addr);
+void mmap_unmap (int mapid);
+void mmap_unmap_all (void);
+bool mmap_copy (struct thread *parent);
+
+#endif /* vm/mmap.h */
@@ -0,0 +1,1086 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/memacct.h"
+#include "userprog/pagedir.h"
+#include "vm/frame.h"
+#include "vm/pagecache.h"
+#include "vm/swap.h"
+#include "vm/wset.h"
+
+/* Default for STACK_PAGE_LIMIT: 8 MB. */
+#define STACK_PAGE_LIMIT_DEFAULT 2048
+
+/* Largest number of pages the stack may grow to. */
+size_t stack_page_limit = STACK_PAGE_LIMIT_DEFAULT;
+
+/* Most pages brought in ahead of a sequential scan by a single
+   fault. */
+#define FAULT_AROUND_MAX 16
+
+/* Bytes below the stack pointer that a push may touch: PUSHA
+   stores 32 bytes below ESP before updating it. */
+#define STACK_SLOP 32
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func page_destroy;
+static struct page *page_add (void *upage, bool writable, enum page_type);
+static void page_release (struct page *);
+static bool page_in_locked (struct page *, bool will_write);
+static void set_frame (struct page *, struct frame *);
+static void charge_frame (struct frame *);
+static void fault_around (struct page *);
+static struct fault_stream *copy_stream (struct thread *parent,
+                                         struct fault_stream *);
+static bool same_source (const struct page *, const struct page *,
+                         size_t distance);
+static bool page_unshare_locked (struct page *);
+static bool page_map_writable (struct page *);
+static bool page_in_cached (struct page *);
+static bool page_load (struct page *, void *kpage);
+static bool cache_read (struct cached_page *, void *kpage);
+static void cache_write_back (struct cached_page *, const void *kpage);
+static unsigned page_sample (struct page *);
+static unsigned age_bucket (unsigned age);
+
+/* Creates the current thread's supplemental page table.
+   Returns true if successful, false on memory allocation
+   failure. */
+bool
+page_table_create (void)
+{
+  struct thread *t = thread_current ();
+
+  ASSERT (t->pages == NULL);
+
+  t->pages = malloc (sizeof *t->pages);
+  if (t->pages == NULL)
+    return false;
+  if (!hash_init (t->pages, page_hash, page_less, NULL))
+    {
+      free (t->pages);
+      t->pages = NULL;
+      return false;
+    }
+  lock_init (&t->pages_lock);
+  list_init (&t->fault_streams);
+  wset_add (t);
+  return true;
+}
+
+/* Destroys the current thread's supplemental page table, if it
+   has one, unmapping and freeing every resident page.  Must be
+   called before the thread's page directory is destroyed. */
+void
+page_table_destroy (void)
+{
+  struct thread *t = thread_current ();
+
+  if (t->pages == NULL)
+    return;
+  wset_remove (t);
+  hash_destroy (t->pages, page_destroy);
+  free (t->pages);
+  t->pages = NULL;
+
+  while (!list_empty (&t->fault_streams))
+    {
+      struct list_elem *e = list_pop_front (&t->fault_streams);
+      free (list_entry (e, struct fault_stream, elem));
+    }
+}
+
+/* Creates fault-around state for a new segment of the current
+   process's executable, to be passed to page_add_file() and
+   page_add_text() for each of its pages.  It is freed along
+   with the supplemental page table.  Returns the new stream, or
+   a null pointer if memory allocation fails. */
+struct fault_stream *
+page_add_stream (void)
+{
+  struct fault_stream *s = malloc (sizeof *s);
+
+  if (s != NULL)
+    {
+      page_init_stream (s);
+      list_push_back (&thread_current ()->fault_streams, &s->elem);
+    }
+  return s;
+}
+
+/* Initializes S, the fault-around state of a mapped file, for a
+   scan that has not started yet. */
+void
+page_init_stream (struct fault_stream *s)
+{
+  s->next = NULL;
+  s->window = 0;
+}
+
+/* Adds a page at UPAGE to the current process's address space
+   whose contents are the READ_BYTES bytes at offset OFS in FILE
+   followed by zeros.  The page is read in when first touched.
+   FILE must stay open as long as the page exists.  STREAM is the
+   fault-around state of the segment that the page belongs to.
+   Returns true if successful, false if UPAGE is already in use
+   or memory allocation fails. */
+bool
+page_add_file (void *upage, struct file *file, off_t ofs,
+               uint32_t read_bytes, bool writable,
+               struct fault_stream *stream)
+{
+  struct page *p;
+
+  ASSERT (read_bytes <= PGSIZE);
+
+  p = page_add (upage, writable, PAGE_FILE);
+  if (p == NULL)
+    return false;
+  p->file = file;
+  p->file_ofs = ofs;
+  p->read_bytes = read_bytes;
+  p->stream = stream;
+  return true;
+}
+
+/* Adds an all-zero page at UPAGE to the current process's
+   address space.  A frame is allocated only when the page is
+   first touched.  Returns true if successful, false if UPAGE is
+   already in use or memory allocation fails. */
+bool
+page_add_zero (void *upage, bool writable)
+{
+  return page_add (upage, writable, PAGE_ZERO) != NULL;
+}
+
+/* Adds a page at UPAGE to the current process's address space
+   that maps the page at offset OFS in INODE, shared with every
+   other process that maps it, through the page cache.  Changes
+   are written back to INODE.  INODE must stay open as long as
+   the page exists.  STREAM is the fault-around state of the
+   mapping.  Returns true if successful, false if UPAGE is
+   already in use or memory allocation fails. */
+bool
+page_add_mmap (void *upage, struct inode *inode, off_t ofs,
+               struct fault_stream *stream)
+{
+  struct cached_page *cp;
+  struct page *p;
+
+  cp = pagecache_get (inode, ofs);
+  if (cp == NULL)
+    return false;
+  p = page_add (upage, true, PAGE_MMAP);
+  if (p == NULL)
+    {
+      pagecache_put (cp);
+      return false;
+    }
+  p->cache = cp;
+  p->stream = stream;
+  return true;
+}
+
+/* Adds a read-only page at UPAGE to the current process's
+   address space whose contents are the READ_BYTES bytes at
+   offset OFS in executable INODE followed by zeros.  The page is
+   shared, through the page cache, with every process running
+   the same executable, so it is read in only once however many
+   processes run it.  INODE must stay open, denying writes, as
+   long as the page exists.  STREAM is the fault-around state of
+   the segment that the page belongs to.  Returns true if
+   successful, false if UPAGE is already in use or memory
+   allocation fails. */
+bool
+page_add_text (void *upage, struct inode *inode, off_t ofs,
+               uint32_t read_bytes, struct fault_stream *stream)
+{
+  struct cached_page *cp;
+  struct page *p;
+
+  cp = pagecache_get_text (inode, ofs, read_bytes);
+  if (cp == NULL)
+    return false;
+  p = page_add (upage, false, PAGE_TEXT);
+  if (p == NULL)
+    {
+      pagecache_put (cp);
+      return false;
+    }
+  p->cache = cp;
+  p->stream = stream;
+  return true;
+}
+
+/* Removes the page at UPAGE from the current process's address
+   space, writing it back first if it is a modified page of a
+   mapped file. */
+void
+page_remove (void *upage)
+{
+  struct page *p = page_lookup (upage);
+
+  if (p != NULL)
+    {
+      struct thread *t = thread_current ();
+
+      lock_acquire (&t->pages_lock);
+      hash_delete (t->pages, &p->hash_elem);
+      lock_release (&t->pages_lock);
+      page_release (p);
+      free (p);
+    }
+}
+
+/* Copies PARENT's address space, except for its mapped files,
+   into the current process, for fork().  Resident pages are
+   shared copy-on-write: both processes map the frame read-only
+   until one of them writes to it.  Pages in swap share the swap
+   slot.  PARENT must not run until this returns.  Returns true
+   if successful, false if memory allocation fails. */
+bool
+page_table_copy (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+  struct hash_iterator i;
+  struct list_elem *e;
+  bool success = true;
+
+  /* Give the child its own fault-around state for each segment,
+     in the same order as the parent's. */
+  for (e = list_begin (&parent->fault_streams);
+       e != list_end (&parent->fault_streams); e = list_next (e))
+    {
+      struct fault_stream *ps = list_entry (e, struct fault_stream, elem);
+      struct fault_stream *s = page_add_stream ();
+      if (s == NULL)
+        return false;
+      s->next = ps->next;
+      s->window = ps->window;
+    }
+
+  /* PARENT is not running, but the working-set sampler may be
+     walking its page table. */
+  lock_acquire (&parent->pages_lock);
+  hash_first (&i, parent->pages);
+  while (hash_next (&i))
+    {
+      struct page *pp = hash_entry (hash_cur (&i), struct page, hash_elem);
+      struct page *c;
+
+      if (pp->type == PAGE_MMAP)
+        continue;
+      c = page_add (pp->upage, pp->writable, pp->type);
+      if (c == NULL)
+        {
+          success = false;
+          break;
+        }
+      c->stream = copy_stream (parent, pp->stream);
+      if (pp->type == PAGE_TEXT)
+        {
+          /* Already shared; found in the page cache on first
+             touch. */
+          pagecache_dup (pp->cache);
+          c->cache = pp->cache;
+          continue;
+        }
+      c->file = pp->file == parent->exec_file ? t->exec_file : pp->file;
+      c->file_ofs = pp->file_ofs;
+      c->read_bytes = pp->read_bytes;
+
+      frame_lock (pp);
+      if (pp->frame != NULL)
+        {
+          struct frame *f = pp->frame;
+
+          /* Contents that the parent modified can no longer be
+             read back from the file, in either process. */
+          if (pagedir_is_dirty (parent->pagedir, pp->upage))
+            pp->type = PAGE_SWAP;
+          c->type = pp->type;
+
+          if (!pagedir_set_page (t->pagedir, c->upage, f->kpage, false))
+            {
+              frame_unlock (f);
+              success = false;
+              break;
+            }
+          pagedir_set_writable (parent->pagedir, pp->upage, false);
+          list_push_back (&f->pages, &c->frame_elem);
+          set_frame (c, f);
+          frame_unlock (f);
+        }
+      else
+        {
+          c->type = pp->type;
+          if (pp->swap_slot != SWAP_NONE)
+            {
+              swap_dup (pp->swap_slot);
+              c->swap_slot = pp->swap_slot;
+            }
+        }
+    }
+  lock_release (&parent->pages_lock);
+  return success;
+}
+
+/* Returns the page containing user virtual address ADDR in the
+   current process's supplemental page table, or a null pointer
+   if there is no such page. */
+struct page *
+page_lookup (const void *addr)
+{
+  struct thread *t = thread_current ();
+  struct page p;
+  struct hash_elem *e;
+
+  if (t->pages == NULL)
+    return NULL;
+  p.upage = pg_round_down (addr);
+  e = hash_find (t->pages, &p.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Brings in the page containing FAULT_ADDR, which must not be
+   present, and maps it into the current process's page
+   directory.  WRITE says whether the fault was a write, which
+   decides whether an all-zero page gets a frame of its own or
+   the shared zero frame.  Returns true if successful, false if
+   FAULT_ADDR is not part of the process's address space, or is
+   read-only and WRITE is true, or if the page could not be
+   loaded. */
+bool
+page_in (const void *fault_addr, bool write)
+{
+  struct page *p = page_lookup (fault_addr);
+
+  if (p == NULL)
+    return false;
+  if (!page_lock (fault_addr, write))
+    return false;
+  frame_unlock (p->frame);
+  fault_around (p);
+  return true;
+}
+
+/* Extends the current process's stack down to the page that
+   contains ADDR, if ADDR looks like an access to the stack given
+   user stack pointer ESP: at or just below ESP, and within
+   stack_page_limit pages of the top of user memory.  Only that
+   one page is added, as an all-zero page, and it is not brought
+   in until touched.  Returns true if the page was added, false
+   if ADDR is not a stack access or memory allocation fails. */
+bool
+page_grow_stack (const void *addr, const void *esp)
+{
+  uint8_t *upage = pg_round_down (addr);
+
+  if ((const uint8_t *) addr + STACK_SLOP < (const uint8_t *) esp
+      || !is_user_vaddr (addr)
+      || (size_t) ((uint8_t *) PHYS_BASE - upage) > stack_page_limit * PGSIZE)
+    return false;
+  return page_add_zero (upage, true);
+}
+
+/* Brings in the page containing ADDR, if necessary, and locks
+   it into memory, so that the kernel can access it without
+   faulting, for example while holding file system locks.  If WILL_WRITE
+   is true, the page must be writable.  Returns true if
+   successful, false if ADDR is not part of the process's
+   address space or the page could not be loaded. */
+bool
+page_lock (const void *addr, bool will_write)
+{
+  struct page *p = page_lookup (addr);
+
+  if (p == NULL || (will_write && !p->writable))
+    return false;
+
+  frame_lock (p);
+  if (p->frame == NULL)
+    {
+      if (!page_in_locked (p, will_write))
+        return false;
+    }
+  /* Resident, but maybe unmapped by an eviction that failed. */
+  else if (pagedir_get_page (p->thread->pagedir, p->upage) == NULL
+           && !pagedir_set_page (p->thread->pagedir, p->upage,
+                                 p->frame->kpage, page_map_writable (p)))
+    {
+      frame_unlock (p->frame);
+      return false;
+    }
+
+  if (will_write)
+    {
+      /* The kernel cannot take a copy-on-write fault on a page
+         whose frame it has locked, so copy it now. */
+      if (!page_map_writable (p) && !page_unshare_locked (p))
+        {
+          frame_unlock (p->frame);
+          return false;
+        }
+
+      /* The kernel writes through its own mapping of the frame,
+         which leaves the user page's dirty bit alone. */
+      pagedir_set_dirty (p->thread->pagedir, p->upage, true);
+    }
+  return true;
+}
+
+/* Handles a write to writable page ADDR that is mapped read-only
+   because it shares its frame copy-on-write, by giving the page a
+   private copy of the frame, or by making it writable if no other
+   page shares the frame any more.  Returns true if the write can
+   be retried, false if ADDR is not a writable page or memory is
+   exhausted. */
+bool
+page_unshare (const void *addr)
+{
+  struct page *p = page_lookup (addr);
+  struct frame *f;
+
+  if (p == NULL || !p->writable)
+    return false;
+
+  frame_lock (p);
+  f = p->frame;
+  if (f == NULL)
+    {
+      /* Evicted meanwhile.  The retried write will fault it back
+         in, privately. */
+      return true;
+    }
+  if (page_map_writable (p))
+    pagedir_set_writable (p->thread->pagedir, p->upage, true);
+  else if (!page_unshare_locked (p))
+    {
+      frame_unlock (f);
+      return false;
+    }
+  frame_unlock (p->frame);
+  return true;
+}
+
+/* Unlocks the page containing ADDR, which must have been locked
+   with page_lock(). */
+void
+page_unlock (const void *addr)
+{
+  struct page *p = page_lookup (addr);
+
+  ASSERT (p != NULL && p->frame != NULL);
+  frame_unlock (p->frame);
+}
+
+/* Evicts the pages mapped to locked frame F: unmaps them, saves
+   their contents if they cannot be read back from where they
+   came from, and detaches them from the frame.  Returns true if
+   successful, false if swap is full; the page then stays
+   resident but unmapped. */
+bool
+page_out (struct frame *f)
+{
+  struct list_elem *e;
+  struct page *p;
+  bool dirty = false;
+
+  ASSERT (lock_held_by_current_thread (&f->lock));
+  ASSERT (!list_empty (&f->pages));
+
+  /* Unmap first, so that the processes fault, and wait for us,
+     rather than modifying the page while we save it. */
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    {
+      p = list_entry (e, struct page, frame_elem);
+      pagedir_clear_page (p->thread->pagedir, p->upage);
+      if (pagedir_is_dirty (p->thread->pagedir, p->upage))
+        dirty = true;
+    }
+
+  /* A modified page of a mapped file is written back to the
+     file.  Any other page that was modified, or whose contents
+     exist only in memory, goes to swap.  Anything else can
+     simply be read back, from its file or as zeros. */
+  p = list_entry (list_front (&f->pages), struct page, frame_elem);
+  if (p->cache != NULL)
+    {
+      if (dirty)
+        cache_write_back (p->cache, f->kpage);
+      p->cache->frame = NULL;
+    }
+  else if (dirty || p->type == PAGE_SWAP)
+    {
+      /* Pages sharing the frame copy-on-write share the slot. */
+      size_t slot = swap_out (f->kpage);
+      for (e = list_begin (&f->pages); e != list_end (&f->pages);
+           e = list_next (e))
+        {
+          p = list_entry (e, struct page, frame_elem);
+          p->type = PAGE_SWAP;
+          p->swap_slot = slot;
+          if (slot != SWAP_NONE && e != list_begin (&f->pages))
+            swap_dup (slot);
+        }
+      if (slot == SWAP_NONE)
+        return false;
+    }
+
+  while (!list_empty (&f->pages))
+    {
+      p = list_entry (list_pop_front (&f->pages), struct page, frame_elem);
+      set_frame (p, NULL);
+    }
+  return true;
+}
+
+/* Returns true if page P has been accessed since the last call,
+   clearing its accessed bit.  The caller must hold P's frame
+   lock. */
+bool
+page_accessed_recently (struct page *p)
+{
+  uint32_t *pd = p->thread->pagedir;
+  bool accessed;
+
+  ASSERT (p->frame != NULL);
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+
+  accessed = pagedir_is_accessed (pd, p->upage);
+  if (accessed)
+    {
+      pagedir_set_accessed (pd, p->upage, false);
+      p->sample_ref = true;
+    }
+  else
+    accessed = p->clock_ref;
+  p->clock_ref = false;
+  return accessed;
+}
+
+/* Samples the accessed bits of process T's resident pages,
+   clearing them, and updates T's working-set estimate.  A page
+   whose frame is locked is in use, so it counts as just accessed
+   without being sampled.  Pages mapped to the zero frame are not
+   resident.  T's PAGES_LOCK must be held. */
+void
+page_table_sample (struct thread *t)
+{
+  struct proc_wsstat *ws = &t->wsstat;
+  struct hash_iterator i;
+
+  ASSERT (lock_held_by_current_thread (&t->pages_lock));
+
+  ws->sample_cnt++;
+  ws->resident_pages = 0;
+  ws->ws_pages = 0;
+  memset (ws->age_hist, 0, sizeof ws->age_hist);
+
+  hash_first (&i, t->pages);
+  while (hash_next (&i))
+    {
+      struct page *p = hash_entry (hash_cur (&i), struct page, hash_elem);
+      struct frame *f = p->frame;
+      unsigned age = 0;
+
+      if (f == NULL || frame_is_zero (f))
+        continue;
+      if (frame_try_lock (p))
+        {
+          age = page_sample (p);
+          frame_unlock (p->frame);
+        }
+
+      ws->resident_pages++;
+      if (age < WSSTAT_WINDOW)
+        ws->ws_pages++;
+      ws->age_hist[age_bucket (age)]++;
+    }
+}
+
+/* Samples page P's accessed bit for the working-set estimator,
+   clearing it, and returns P's idle age.  The clock still gets
+   to see the access.  P's frame must be locked. */
+static unsigned
+page_sample (struct page *p)
+{
+  uint32_t *pd = p->thread->pagedir;
+  bool accessed;
+
+  ASSERT (lock_held_by_current_thread (&p->frame->lock));
+
+  accessed = pagedir_is_accessed (pd, p->upage);
+  if (accessed)
+    {
+      pagedir_set_accessed (pd, p->upage, false);
+      p->clock_ref = true;
+    }
+  if (accessed || p->sample_ref)
+    p->idle_age = 0;
+  else if (p->idle_age < UINT8_MAX)
+    p->idle_age++;
+  p->sample_ref = false;
+  return p->idle_age;
+}
+
+/* Returns the index in struct proc_wsstat's AGE_HIST of idle
+   age AGE. */
+static unsigned
+age_bucket (unsigned age)
+{
+  unsigned bucket = 0;
+
+  while (age > 0 && bucket < WSSTAT_AGE_CNT - 1)
+    {
+      age >>= 1;
+      bucket++;
+    }
+  return bucket;
+}
+
+/* Allocates a frame for page P, which must not be resident,
+   fills it and maps it.  An all-zero page that is not about to
+   be written, as WILL_WRITE says, is mapped read-only to the
+   zero frame instead.  Returns true if successful, with P's
+   frame locked, false on failure. */
+static bool
+page_in_locked (struct page *p, bool will_write)
+{
+  struct frame *f;
+
+  if (p->cache != NULL)
+    return page_in_cached (p);
+
+  if (p->type == PAGE_ZERO && !will_write)
+    {
+      f = frame_zero_lock (p);
+      if (!pagedir_set_page (p->thread->pagedir, p->upage, f->kpage, false))
+        {
+          list_remove (&p->frame_elem);
+          frame_unlock (f);
+          return false;
+        }
+      set_frame (p, f);
+      return true;
+    }
+
+  f = frame_alloc_and_lock (p, p->type == PAGE_ZERO);
+  if (f == NULL)
+    return false;
+  if (!page_load (p, f->kpage)
+      || !pagedir_set_page (p->thread->pagedir, p->upage, f->kpage,
+                            p->writable))
+    {
+      list_remove (&p->frame_elem);
+      frame_free (f);
+      return false;
+    }
+  set_frame (p, f);
+  return true;
+}
+
+/* Called after page P of the current process has been faulted
+   in.  If P is where a sequential scan of its mapping or segment
+   would fault next, brings in the pages that follow it from the
+   same file as well, doubling the number each time the scan
+   continues, up to FAULT_AROUND_MAX, as a file system's
+   read-ahead does.  The pages are mapped with their accessed
+   bits clear, so if the scan does not reach them, they are the
+   first candidates for eviction. */
+static void
+fault_around (struct page *p)
+{
+  struct fault_stream *s = p->stream;
+  uint8_t *next = (uint8_t *) p->upage + PGSIZE;
+  unsigned i;
+
+  if ((p->type != PAGE_FILE && p->cache == NULL) || s == NULL)
+    return;
+
+  if (p->upage != s->next)
+    s->window = 0;
+  else if (s->window == 0)
+    s->window = 1;
+  else if (s->window < FAULT_AROUND_MAX)
+    s->window *= 2;
+
+  for (i = 1; i <= s->window; i++, next += PGSIZE)
+    {
+      struct page *q = page_lookup (next);
+
+      if (q == NULL || !same_source (p, q, i))
+        break;
+      frame_lock (q);
+      if (q->frame == NULL)
+        {
+          if (!page_in_locked (q, false))
+            break;
+        }
+      frame_unlock (q->frame);
+    }
+  s->next = next;
+}
+
+/* Returns the current process's counterpart of PARENT's segment
+   fault stream PS, which page_table_copy() has already created
+   at the same position in the list, or a null pointer if PS is
+   null. */
+static struct fault_stream *
+copy_stream (struct thread *parent, struct fault_stream *ps)
+{
+  struct list *streams = &thread_current ()->fault_streams;
+  struct list_elem *pe, *e;
+
+  if (ps == NULL)
+    return NULL;
+  for (pe = list_begin (&parent->fault_streams), e = list_begin (streams);
+       pe != &ps->elem; pe = list_next (pe), e = list_next (e))
+    ASSERT (e != list_end (streams));
+  return list_entry (e, struct fault_stream, elem);
+}
+
+/* Returns true if page Q holds the part of the same file that
+   comes DISTANCE pages after page P's. */
+static bool
+same_source (const struct page *p, const struct page *q, size_t distance)
+{
+  off_t delta = distance * PGSIZE;
+
+  if (p->type != q->type)
+    return false;
+  if (p->cache != NULL)
+    return (q->cache->inode == p->cache->inode
+            && q->cache->ofs == p->cache->ofs + delta);
+  return q->file == p->file && q->file_ofs == p->file_ofs + delta;
+}
+
+/* Gives page P, whose frame the caller has locked and shares
+   copy-on-write with other pages, a private copy of the frame,
+   mapped writable.  Returns true if successful, with P's new
+   frame locked and the old one unlocked, false if memory is
+   exhausted. */
+static bool
+page_unshare_locked (struct page *p)
+{
+  struct frame *old = p->frame;
+  struct frame *new;
+  uint32_t *pd = p->thread->pagedir;
+  bool zero = frame_is_zero (old);
+
+  list_remove (&p->frame_elem);
+
+  /* Every zero page of every process shares the zero frame, so
+     don't keep the others waiting while we find a frame.  Nobody
+     else can change P meanwhile: it is not in any frame table
+     entry that eviction could find. */
+  if (zero)
+    frame_unlock (old);
+  new = frame_alloc_and_lock (p, zero);
+  if (zero)
+    lock_acquire (&old->lock);
+  if (new == NULL)
+    {
+      list_push_back (&old->pages, &p->frame_elem);
+      return false;
+    }
+  if (!zero)
+    memcpy (new->kpage, old->kpage, PGSIZE);
+
+  /* The copy exists only in memory from now on. */
+  pagedir_clear_page (pd, p->upage);
+  set_frame (p, new);
+  p->type = PAGE_SWAP;
+  p->swap_slot = SWAP_NONE;
+  frame_unlock (old);
+
+  /* P's page table exists, so this cannot fail. */
+  pagedir_set_page (pd, p->upage, new->kpage, true);
+  return true;
+}
+
+/* Returns true if page P, whose frame the caller has locked, may
+   be mapped writable: it must be writable and not share its
+   frame copy-on-write or be mapped to the zero frame.  Pages of
+   mapped files share their frames but stay writable. */
+static bool
+page_map_writable (struct page *p)
+{
+  struct list *pages = &p->frame->pages;
+
+  return (p->writable
+          && !frame_is_zero (p->frame)
+          && (p->type == PAGE_MMAP || list_begin (pages) == list_rbegin (pages)));
+}
+
+/* Maps cached page P, which must not be resident, to the
+   frame that holds its cached page, reading the page in first
+   if no process has it in memory.  Returns true if successful,
+   with P's frame locked, false on failure. */
+static bool
+page_in_cached (struct page *p)
+{
+  struct cached_page *cp = p->cache;
+  struct frame *f;
+
+  lock_acquire (&cp->lock);
+  f = cp->frame;
+  if (f != NULL)
+    {
+      lock_acquire (&f->lock);
+      if (f == cp->frame)
+        list_push_back (&f->pages, &p->frame_elem);
+      else
+        {
+          /* Evicted while we waited. */
+          lock_release (&f->lock);
+          f = NULL;
+        }
+    }
+  if (f == NULL)
+    {
+      f = frame_alloc_and_lock (p, false);
+      if (f == NULL)
+        {
+          lock_release (&cp->lock);
+          return false;
+        }
+      if (!cache_read (cp, f->kpage))
+        {
+          list_remove (&p->frame_elem);
+          frame_free (f);
+          lock_release (&cp->lock);
+          return false;
+        }
+      cp->frame = f;
+    }
+  lock_release (&cp->lock);
+
+  if (!pagedir_set_page (p->thread->pagedir, p->upage, f->kpage,
+                         p->writable))
+    {
+      list_remove (&p->frame_elem);
+      if (list_empty (&f->pages))
+        {
+          cp->frame = NULL;
+          frame_free (f);
+        }
+      else
+        frame_unlock (f);
+      return false;
+    }
+  set_frame (p, f);
+  return true;
+}
+
+/* Fills KPAGE with the contents of page P.  Returns true if
+   successful, false on a file read error. */
+static bool
+page_load (struct page *p, void *kpage)
+{
+  bool success;
+
+  if (p->type == PAGE_ZERO)
+    return true;
+  if (p->type == PAGE_SWAP)
+    {
+      /* The slot is freed: from now on the contents exist only
+         in memory until the page is evicted again. */
+      swap_in (p->swap_slot, kpage);
+      p->swap_slot = SWAP_NONE;
+      return true;
+    }
+
+  success = (file_read_at (p->file, kpage, p->read_bytes, p->file_ofs)
+             == (off_t) p->read_bytes);
+  memset ((uint8_t *) kpage + p->read_bytes, 0, PGSIZE - p->read_bytes);
+  return success;
+}
+
+/* Reads cached page CP into KPAGE, zeroing whatever lies past
+   the end of the file, or of the segment for a text page.
+   Returns true if successful, false on a read error. */
+static bool
+cache_read (struct cached_page *cp, void *kpage)
+{
+  off_t length;
+  bool success;
+
+  if (!cp->text)
+    {
+      length = inode_length (cp->inode) - cp->ofs;
+      cp->read_bytes = length <= 0 ? 0 : length < PGSIZE ? length : PGSIZE;
+    }
+  success = (inode_read_at (cp->inode, kpage, cp->read_bytes, cp->ofs)
+             == (off_t) cp->read_bytes);
+  memset ((uint8_t *) kpage + cp->read_bytes, 0, PGSIZE - cp->read_bytes);
+  return success;
+}
+
+/* Writes KPAGE, the contents of cached page CP, back to its
+   file.  Only the bytes that were read from the file are
+   written, so the file never grows. */
+static void
+cache_write_back (struct cached_page *cp, const void *kpage)
+{
+  inode_write_at (cp->inode, kpage, cp->read_bytes, cp->ofs);
+}
+
+/* Creates a page of the given TYPE at UPAGE and inserts it into
+   the current process's supplemental page table.  Returns the
+   new page, or a null pointer if UPAGE is already in use or
+   memory allocation fails. */
+static struct page *
+page_add (void *upage, bool writable, enum page_type type)
+{
+  struct thread *t = thread_current ();
+  struct page *p;
+  struct hash_elem *e;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (is_user_vaddr (upage));
+
+  p = calloc (1, sizeof *p);
+  if (p == NULL)
+    return NULL;
+  p->thread = t;
+  p->upage = upage;
+  p->writable = writable;
+  p->type = type;
+  p->swap_slot = SWAP_NONE;
+
+  lock_acquire (&t->pages_lock);
+  e = hash_insert (t->pages, &p->hash_elem);
+  lock_release (&t->pages_lock);
+  if (e != NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Unmaps page P from its process and releases what backs it: a
+   modified page of a mapped file is written back, its frame,
+   unless still shared, or swap slot is freed, and its page cache
+   entry is released. */
+static void
+page_release (struct page *p)
+{
+  frame_lock (p);
+  if (p->frame != NULL)
+    {
+      struct frame *f = p->frame;
+      uint32_t *pd = p->thread->pagedir;
+
+      pagedir_clear_page (pd, p->upage);
+      if (p->cache != NULL && pagedir_is_dirty (pd, p->upage))
+        cache_write_back (p->cache, f->kpage);
+
+      list_remove (&p->frame_elem);
+      set_frame (p, NULL);
+      if (list_empty (&f->pages) && !frame_is_zero (f))
+        {
+          if (p->cache != NULL)
+            p->cache->frame = NULL;
+          frame_free (f);
+        }
+      else
+        frame_unlock (f);
+    }
+  else if (p->swap_slot != SWAP_NONE)
+    swap_free (p->swap_slot);
+
+  if (p->cache != NULL)
+    pagecache_put (p->cache);
+}
+
+/* Sets page P's frame to F, which may be null.  P must already
+   be on F's page list, and off that of its old frame.
+
+   Each frame other than the zero frame is charged to exactly one
+   of the processes that map it, so a frame shared copy-on-write
+   after fork() counts only against the process that brought it
+   in, until a write gives the other a copy of its own.  If P
+   paid for its old frame, the charge passes to another of the
+   old frame's pages, if any. */
+static void
+set_frame (struct page *p, struct frame *f)
+{
+  struct frame *old = p->frame;
+
+  if (p->charged)
+    {
+      p->charged = false;
+      memacct_user_pages (p->thread, -1);
+      charge_frame (old);
+    }
+
+  /* A page brought in was just accessed. */
+  if (old == NULL)
+    {
+      p->idle_age = 0;
+      p->sample_ref = p->clock_ref = false;
+    }
+  p->frame = f;
+  if (f != NULL)
+    charge_frame (f);
+}
+
+/* Charges the process of one of the pages mapping frame F for
+   F, unless F is the zero frame, no page maps it, or one of its
+   pages is already charged.  The caller must hold F's lock. */
+static void
+charge_frame (struct frame *f)
+{
+  struct list_elem *e;
+  struct page *p;
+
+  if (frame_is_zero (f) || list_empty (&f->pages))
+    return;
+  for (e = list_begin (&f->pages); e != list_end (&f->pages);
+       e = list_next (e))
+    if (list_entry (e, struct page, frame_elem)->charged)
+      return;
+
+  p = list_entry (list_front (&f->pages), struct page, frame_elem);
+  p->charged = true;
+  memacct_user_pages (p->thread, 1);
+}
+
+/* Releases and frees page E. */
+static void
+page_destroy (struct hash_elem *e, void *aux UNUSED)
+{
+  struct page *p = hash_entry (e, struct page, hash_elem);
+
+  page_release (p);
+  free (p);
+}
+
+/* Returns a hash value for page E. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return hash_bytes (&p->upage, sizeof p->upage);
+}
+
+/* Returns true if page A precedes page B. */
+static bool
+page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+           void *aux UNUSED)
+{
+  const struct page *a = hash_entry (a_, struct page, hash_elem);
+  const struct page *b = hash_entry (b_, struct page, hash_elem);
+  return a->upage < b->upage;
+}
@@ -0,0 +1,114 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+
+struct inode;
+struct thread;
+
+/* Where the contents of a virtual page come from. */
+enum page_type
+  {
+    PAGE_FILE,                  /* Read from a file, rest zeroed. */
+    PAGE_ZERO,                  /* All zeros. */
+    PAGE_SWAP,                  /* Modified; kept in swap when evicted. */
+    PAGE_MMAP,                  /* Shared page of a mapped file. */
+    PAGE_TEXT                   /* Shared read-only executable page. */
+  };
+
+/* A run of sequential page faults through one mapped file or
+   one segment of an executable, followed by fault_around() in
+   vm/page.c.  Each mapping and each segment has its own, so that
+   scans of two of them at once do not reset each other. */
+struct fault_stream
+  {
+    struct list_elem elem;      /* Segments: element in thread's
+                                   FAULT_STREAMS list. */
+    void *next;                 /* Page the scan would fault on next. */
+    unsigned window;            /* Pages to fault around. */
+  };
+
+/* A virtual page in a user process's supplemental page table.
+
+   The supplemental page table records every page of the
+   process's address space, whether or not it is currently
+   mapped in the page directory, along with enough information
+   to bring it in when it is first touched.
+
+   A page's frame, and its type and swap slot while it is not
+   resident, may only be changed with the frame locked (see
+   frame_lock()), because another thread may be evicting it.
+   Pages are only added to and removed from the table with its
+   owner's PAGES_LOCK held, because the working-set sampler walks
+   it. */
+struct page
+  {
+    struct hash_elem hash_elem; /* Element in thread's page table. */
+    struct thread *thread;      /* Owning thread. */
+    void *upage;                /* User virtual address. */
+    bool writable;              /* Mapped writable? */
+    enum page_type type;        /* Source of the contents. */
+    struct frame *frame;        /* Frame holding the page, or null. */
+    struct list_elem frame_elem; /* Element in frame's page list. */
+    bool charged;               /* Process charged for FRAME? */
+
+    /* PAGE_FILE only. */
+    struct file *file;          /* File to read. */
+    off_t file_ofs;             /* Offset in FILE. */
+    uint32_t read_bytes;        /* Bytes to read; the rest are zero. */
+
+    /* PAGE_SWAP only. */
+    size_t swap_slot;           /* Slot while evicted, else SWAP_NONE. */
+
+    /* PAGE_MMAP and PAGE_TEXT only; null otherwise. */
+    struct cached_page *cache;  /* Page cache entry. */
+
+    /* Pages of a mapped file or of an executable segment, even
+       after they move to swap; null otherwise. */
+    struct fault_stream *stream; /* Sequential fault state. */
+
+    /* Working-set estimation (see vm/wset.c).  The clock and the
+       sampler both clear the page's accessed bit, so each tells
+       the other what it saw. */
+    uint8_t idle_age;           /* Samples since last seen accessed. */
+    bool sample_ref;            /* Accessed bit seen by the clock. */
+    bool clock_ref;             /* Accessed bit seen by the sampler. */
+  };
+
+/* Maximum size of a process's stack, in pages.
+   Controlled by kernel command-line option "-stack". */
+extern size_t stack_page_limit;
+
+bool page_table_create (void);
+void page_table_destroy (void);
+bool page_table_copy (struct thread *parent);
+
+struct fault_stream *page_add_stream (void);
+void page_init_stream (struct fault_stream *);
+
+bool page_add_file (void *upage, struct file *, off_t, uint32_t read_bytes,
+                    bool writable, struct fault_stream *);
+bool page_add_zero (void *upage, bool writable);
+bool page_add_mmap (void *upage, struct inode *, off_t,
+                    struct fault_stream *);
+bool page_add_text (void *upage, struct inode *, off_t, uint32_t read_bytes,
+                    struct fault_stream *);
+void page_remove (void *upage);
+struct page *page_lookup (const void *);
+bool page_in (const void *fault_addr, bool write);
+bool page_grow_stack (const void *addr, const void *esp);
+bool page_out (struct frame *);
+bool page_accessed_recently (struct page *);
+void page_table_sample (struct thread *);
+
+bool page_unshare (const void *);
+
+bool page_lock (const void *, bool will_write);
+void page_unlock (const void *);
+
+#endif /* vm/page.h */
@@ -0,0 +1,143 @@
+#include "vm/pagecache.h"
+#include <debug.h>
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
+
+/* All cached pages, keyed by inode and offset. */
+static struct hash cache;
+
+/* Protects CACHE and every entry's REF_CNT. */
+static struct lock cache_lock;
+
+static hash_hash_func cached_page_hash;
+static hash_less_func cached_page_less;
+static struct cached_page *lookup (struct inode *, off_t, bool text,
+                                   uint32_t read_bytes);
+
+/* Initializes the page cache. */
+void
+pagecache_init (void)
+{
+  if (!hash_init (&cache, cached_page_hash, cached_page_less, NULL))
+    PANIC ("couldn't create page cache");
+  lock_init (&cache_lock);
+}
+
+/* Returns the cache entry for the page at offset OFS in INODE,
+   mapped with mmap(), creating it if necessary, and takes a
+   reference to it.  INODE must stay open until the reference is
+   released with pagecache_put().  Returns a null pointer if
+   memory allocation fails. */
+struct cached_page *
+pagecache_get (struct inode *inode, off_t ofs)
+{
+  return lookup (inode, ofs, false, 0);
+}
+
+/* Returns the cache entry for the page at offset OFS in
+   executable INODE whose first READ_BYTES bytes come from the
+   file and the rest are zeros, creating it if necessary, and
+   takes a reference to it, like pagecache_get().  INODE must
+   deny writes as long as the entry exists. */
+struct cached_page *
+pagecache_get_text (struct inode *inode, off_t ofs, uint32_t read_bytes)
+{
+  return lookup (inode, ofs, true, read_bytes);
+}
+
+/* Takes another reference to CP, which the caller holds one
+   to. */
+void
+pagecache_dup (struct cached_page *cp)
+{
+  lock_acquire (&cache_lock);
+  ASSERT (cp->ref_cnt > 0);
+  cp->ref_cnt++;
+  lock_release (&cache_lock);
+}
+
+/* Releases a reference to CP, freeing it when the last one goes
+   away.  By then no page can be mapped to CP's frame, so the
+   caller must already have released it. */
+void
+pagecache_put (struct cached_page *cp)
+{
+  lock_acquire (&cache_lock);
+  ASSERT (cp->ref_cnt > 0);
+  if (--cp->ref_cnt == 0)
+    {
+      ASSERT (cp->frame == NULL);
+      hash_delete (&cache, &cp->hash_elem);
+      free (cp);
+    }
+  lock_release (&cache_lock);
+}
+
+/* Returns the entry for the page at offset OFS in INODE of the
+   given kind, creating it with READ_BYTES if necessary, and
+   takes a reference to it.  Returns a null pointer if memory
+   allocation fails. */
+static struct cached_page *
+lookup (struct inode *inode, off_t ofs, bool text, uint32_t read_bytes)
+{
+  struct cached_page key, *cp;
+  struct hash_elem *e;
+
+  ASSERT (ofs % PGSIZE == 0);
+  ASSERT (read_bytes <= PGSIZE);
+
+  key.inode = inode;
+  key.ofs = ofs;
+  key.text = text;
+
+  lock_acquire (&cache_lock);
+  e = hash_find (&cache, &key.hash_elem);
+  if (e != NULL)
+    cp = hash_entry (e, struct cached_page, hash_elem);
+  else
+    {
+      cp = malloc (sizeof *cp);
+      if (cp == NULL)
+        {
+          lock_release (&cache_lock);
+          return NULL;
+        }
+      cp->inode = inode;
+      cp->ofs = ofs;
+      cp->text = text;
+      cp->ref_cnt = 0;
+      lock_init (&cp->lock);
+      cp->frame = NULL;
+      cp->read_bytes = read_bytes;
+      hash_insert (&cache, &cp->hash_elem);
+    }
+  cp->ref_cnt++;
+  lock_release (&cache_lock);
+  return cp;
+}
+
+/* Returns a hash value for cached page E. */
+static unsigned
+cached_page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct cached_page *cp = hash_entry (e, struct cached_page,
+                                             hash_elem);
+  return (hash_bytes (&cp->inode, sizeof cp->inode)
+          ^ hash_int (cp->ofs) ^ cp->text);
+}
+
+/* Returns true if cached page A precedes cached page B. */
+static bool
+cached_page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+                  void *aux UNUSED)
+{
+  const struct cached_page *a = hash_entry (a_, struct cached_page,
+                                            hash_elem);
+  const struct cached_page *b = hash_entry (b_, struct cached_page,
+                                            hash_elem);
+  if (a->inode != b->inode)
+    return a->inode < b->inode;
+  if (a->ofs != b->ofs)
+    return a->ofs < b->ofs;
+  return a->text < b->text;
+}
@@ -0,0 +1,46 @@
+#ifndef VM_PAGECACHE_H
+#define VM_PAGECACHE_H
+
+#include <hash.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+#include "threads/synch.h"
+
+struct inode;
+
+/* A page of a file shared by every process that maps it.
+
+   There is at most one entry for each page of each inode mapped
+   with mmap(), and one for each page of each executable's
+   read-only segments, and while the page is resident every
+   mapping of it uses the same frame.  The two kinds are kept
+   apart because a text page ends in zeros wherever its segment
+   ends, not where the file does, and because writes to a mapped
+   file must never show through in a running program's code. */
+struct cached_page
+  {
+    struct hash_elem hash_elem; /* Element in the page cache. */
+    struct inode *inode;        /* File. */
+    off_t ofs;                  /* Page-aligned offset in INODE. */
+    bool text;                  /* Read-only executable page? */
+    int ref_cnt;                /* Pages that refer to this entry. */
+
+    /* Held while the page is being brought in, so that two
+       processes faulting on it at once don't both read it. */
+    struct lock lock;
+
+    /* Protected by the frame's lock, like struct page's. */
+    struct frame *frame;        /* Frame holding the page, or null. */
+    uint32_t read_bytes;        /* Bytes read from INODE into FRAME;
+                                   fixed for a text page. */
+  };
+
+void pagecache_init (void);
+struct cached_page *pagecache_get (struct inode *, off_t);
+struct cached_page *pagecache_get_text (struct inode *, off_t,
+                                        uint32_t read_bytes);
+void pagecache_dup (struct cached_page *);
+void pagecache_put (struct cached_page *);
+
+#endif /* vm/pagecache.h */
@@ -0,0 +1,105 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include "devices/block.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* The swap device. */
+static struct block *swap_device;
+
+/* Used swap slots, one page each. */
+static struct bitmap *swap_bitmap;
+
+/* Number of pages sharing each used slot.  A slot is shared when
+   a process that has a page in swap forks. */
+static uint16_t *swap_refs;
+
+/* Protects SWAP_BITMAP and SWAP_REFS. */
+static struct lock swap_lock;
+
+/* Number of sectors per page. */
+#define PAGE_SECTORS (PGSIZE / BLOCK_SECTOR_SIZE)
+
+/* Sets up swap on the block device in the BLOCK_SWAP role.
+   Without one, swap_out() always fails. */
+void
+swap_init (void)
+{
+  size_t slot_cnt = 0;
+
+  swap_device = block_get_role (BLOCK_SWAP);
+  if (swap_device != NULL)
+    slot_cnt = block_size (swap_device) / PAGE_SECTORS;
+  else
+    printf ("no swap device--swap disabled\n");
+
+  swap_bitmap = bitmap_create (slot_cnt);
+  swap_refs = calloc (slot_cnt, sizeof *swap_refs);
+  if (swap_bitmap == NULL || (swap_refs == NULL && slot_cnt > 0))
+    PANIC ("couldn't create swap bitmap");
+  lock_init (&swap_lock);
+}
+
+/* Writes the page at KPAGE to a free swap slot and returns the
+   slot, or SWAP_NONE if swap is full. */
+size_t
+swap_out (const void *kpage)
+{
+  size_t slot;
+  size_t i;
+
+  lock_acquire (&swap_lock);
+  slot = bitmap_scan_and_flip (swap_bitmap, 0, 1, false);
+  if (slot != BITMAP_ERROR)
+    swap_refs[slot] = 1;
+  lock_release (&swap_lock);
+  if (slot == BITMAP_ERROR)
+    return SWAP_NONE;
+
+  for (i = 0; i < PAGE_SECTORS; i++)
+    block_write (swap_device, slot * PAGE_SECTORS + i,
+                 (const uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+  return slot;
+}
+
+/* Reads swap SLOT into KPAGE and releases the caller's reference
+   to the slot. */
+void
+swap_in (size_t slot, void *kpage)
+{
+  size_t i;
+
+  ASSERT (bitmap_test (swap_bitmap, slot));
+
+  for (i = 0; i < PAGE_SECTORS; i++)
+    block_read (swap_device, slot * PAGE_SECTORS + i,
+                (uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+  swap_free (slot);
+}
+
+/* Adds a reference to swap SLOT, for another page with the same
+   contents. */
+void
+swap_dup (size_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (swap_bitmap, slot));
+  ASSERT (swap_refs[slot] < UINT16_MAX);
+  swap_refs[slot]++;
+  lock_release (&swap_lock);
+}
+
+/* Releases a reference to swap SLOT without reading it, freeing
+   the slot when the last reference goes away. */
+void
+swap_free (size_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (swap_bitmap, slot));
+  if (--swap_refs[slot] == 0)
+    bitmap_reset (swap_bitmap, slot);
+  lock_release (&swap_lock);
+}
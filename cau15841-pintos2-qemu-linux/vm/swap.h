@@ -0,0 +1,16 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* A swap slot that does not exist. */
+#define SWAP_NONE SIZE_MAX
+
+void swap_init (void);
+size_t swap_out (const void *kpage);
+void swap_in (size_t slot, void *kpage);
+void swap_dup (size_t slot);
+void swap_free (size_t slot);
+
+#endif /* vm/swap.h */
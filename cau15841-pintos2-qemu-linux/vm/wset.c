@@ -0,0 +1,110 @@
+#include "vm/wset.h"
+#include <debug.h>
+#include <list.h>
+#include "devices/timer.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "vm/page.h"
+
+/* Working-set estimation.
+
+   A kernel thread wakes up every WSET_PERIOD_MS milliseconds and
+   samples the accessed bits of every process's resident pages
+   (see page_table_sample()).  Each page's idle age counts the
+   samples since its accessed bit was last seen set, and each
+   process's working set is its pages with an idle age below
+   WSSTAT_WINDOW.
+
+   The clock algorithm in vm/frame.c reads and clears the same
+   accessed bits, so the two pass on what they see to each other
+   through the pages' SAMPLE_REF and CLOCK_REF flags: an access
+   still buys a page its second chance after the sampler cleared
+   its bit. */
+
+/* Default for WSET_PERIOD_MS. */
+#define WSET_PERIOD_MS_DEFAULT 1000
+
+uint32_t wset_period_ms = WSET_PERIOD_MS_DEFAULT;
+
+/* Processes with a supplemental page table. */
+static struct list procs;
+
+/* Protects PROCS.  Held during a whole pass of the sampler, so
+   that no process can free its page table while it is being
+   walked. */
+static struct lock procs_lock;
+
+static thread_func sampler;
+
+/* Initializes working-set estimation and starts the sampler. */
+void
+wset_init (void)
+{
+  list_init (&procs);
+  lock_init (&procs_lock);
+  if (wset_period_ms > 0)
+    thread_create ("wset", PRI_DEFAULT, sampler, NULL);
+}
+
+/* Starts sampling process T, whose supplemental page table has
+   just been created. */
+void
+wset_add (struct thread *t)
+{
+  lock_acquire (&procs_lock);
+  list_push_back (&procs, &t->wset_elem);
+  lock_release (&procs_lock);
+}
+
+/* Stops sampling process T, whose supplemental page table is
+   about to be destroyed. */
+void
+wset_remove (struct thread *t)
+{
+  lock_acquire (&procs_lock);
+  list_remove (&t->wset_elem);
+  lock_release (&procs_lock);
+}
+
+/* Copies the running process's working-set estimate into
+   *STATS.  Returns false if the process has no supplemental
+   page table. */
+bool
+wset_get (struct proc_wsstat *stats)
+{
+  struct thread *t = thread_current ();
+
+  if (t->pages == NULL)
+    return false;
+  lock_acquire (&t->pages_lock);
+  *stats = t->wsstat;
+  lock_release (&t->pages_lock);
+  stats->sample_ms = wset_period_ms;
+  return true;
+}
+
+/* Samples every process's pages once per period.  The pages
+   lock keeps a process from changing its page table during its
+   sample. */
+static void
+sampler (void *aux UNUSED)
+{
+  for (;;)
+    {
+      struct list_elem *e;
+
+      timer_msleep (wset_period_ms);
+
+      lock_acquire (&procs_lock);
+      for (e = list_begin (&procs); e != list_end (&procs);
+           e = list_next (e))
+        {
+          struct thread *t = list_entry (e, struct thread, wset_elem);
+
+          lock_acquire (&t->pages_lock);
+          page_table_sample (t);
+          lock_release (&t->pages_lock);
+        }
+      lock_release (&procs_lock);
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef VM_WSET_H
+#define VM_WSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct proc_wsstat;
+struct thread;
+
+/* Working-set sampling period in milliseconds, or 0 to disable
+   sampling.  Controlled by kernel command-line option "-wset". */
+extern uint32_t wset_period_ms;
+
+void wset_init (void);
+void wset_add (struct thread *);
+void wset_remove (struct thread *);
+bool wset_get (struct proc_wsstat *);
+
+#endif /* vm/wset.h */